@@ -5,6 +5,7 @@ INCLUDEPATH += .
 CONFIG += release
 QT += core network xml
 QMAKE_CXXFLAGS += -std=c++11
+LIBS += -lz
 
 unix:target.path=/usr/local/bin
 unix:target.files=Skyscraper
@@ -23,11 +24,28 @@ DEFINES+=VERSION=\\\"$$VERSION\\\"
 
 HEADERS += src/skyscraper.h \
            src/netcomm.h \
+           src/netreply.h \
+           src/hostgovernor.h \
+           src/journal.h \
+           src/entryspool.h \
+           src/crc32.h \
+           src/romreader.h \
+           src/hashcache.h \
+           src/zipreader.h \
+           src/fingerprint.h \
+           src/hashkernels.h \
+           src/sha1.h \
+           src/dupetracker.h \
+           src/manifest.h \
+           src/binarydb.h \
+           src/xmlindex.h \
+           src/platformrun.h \
            src/xmlreader.h \
            src/settings.h \
            src/compositor.h \
            src/strtools.h \
            src/scraperworker.h \
+           src/asyncworker.h \
            src/localdb.h \
            src/localscraper.h \
            src/importscraper.h \
@@ -42,15 +60,35 @@ HEADERS += src/skyscraper.h \
            src/screenscraper.h \
            src/arcadedb.h \
            src/scripter.h \
-           src/platform.h
+           src/platform.h \
+           src/queue.h \
+           src/scrapequeue.h \
+           src/hashstage.h \
+           src/writestage.h
            
 SOURCES += src/main.cpp \
            src/skyscraper.cpp \
            src/netcomm.cpp \
+           src/netreply.cpp \
+           src/hostgovernor.cpp \
+           src/journal.cpp \
+           src/entryspool.cpp \
+           src/crc32.cpp \
+           src/romreader.cpp \
+           src/hashcache.cpp \
+           src/zipreader.cpp \
+           src/fingerprint.cpp \
+           src/hashkernels.cpp \
+           src/sha1.cpp \
+           src/dupetracker.cpp \
+           src/manifest.cpp \
+           src/binarydb.cpp \
+           src/xmlindex.cpp \
            src/xmlreader.cpp \
            src/compositor.cpp \
            src/strtools.cpp \
            src/scraperworker.cpp \
+           src/asyncworker.cpp \
            src/localdb.cpp \
            src/localscraper.cpp \
            src/importscraper.cpp \
@@ -65,4 +103,8 @@ SOURCES += src/main.cpp \
            src/screenscraper.cpp \
            src/arcadedb.cpp \
            src/scripter.cpp \
-           src/platform.cpp
+           src/platform.cpp \
+           src/queue.cpp \
+           src/scrapequeue.cpp \
+           src/hashstage.cpp \
+           src/writestage.cpp
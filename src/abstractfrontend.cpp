@@ -42,7 +42,7 @@ void AbstractFrontend::checkReqs()
 {
 }
 
-void AbstractFrontend::assembleList(QString &, const QList<GameEntry> &, int)
+void AbstractFrontend::assembleList(QIODevice &, EntrySpool &, int)
 {
 }
 
@@ -80,8 +80,8 @@ QString AbstractFrontend::getVideosFolder()
   return QString();
 }
 
-void AbstractFrontend::sortEntries(QList<GameEntry> &gameEntries)
+// Entries are written to the gamelist ordered by this key
+QString AbstractFrontend::getSortKey(const GameEntry &entry)
 {
-  qSort(gameEntries.begin(), gameEntries.end(), 
-	[](const GameEntry a, const GameEntry b) -> bool { return a.title.toLower() < b.title.toLower(); });
+  return entry.title.toLower();
 }
@@ -31,6 +31,7 @@
 
 #include "gameentry.h"
 #include "settings.h"
+#include "entryspool.h"
 
 class AbstractFrontend : public QObject
 {
@@ -41,8 +42,7 @@ public:
   virtual ~AbstractFrontend();
   void setConfig(Settings *config);
   virtual void checkReqs();
-  virtual void assembleList(QString &finalOutput, const QList<GameEntry> &gameEntries,
-			    int maxLength);
+  virtual void assembleList(QIODevice &output, EntrySpool &gameEntries, int maxLength);
   virtual void skipExisting(const QString &gameListFileString, QList<GameEntry> &gameEntries,
 			    QList<QFileInfo> &inputFiles);
   virtual bool canSkip();
@@ -51,7 +51,7 @@ public:
   virtual QString getGameListFolder();
   virtual QString getImagesFolder();
   virtual QString getVideosFolder();
-  virtual void sortEntries(QList<GameEntry> &gameEntries);
+  virtual QString getSortKey(const GameEntry &entry);
 
 protected:
   Settings *config;
@@ -23,11 +23,14 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
  */
 
+#include <QUrl>
+
 #include "abstractscraper.h"
 #include "platform.h"
 
 AbstractScraper::AbstractScraper()
 {
+  netComm = &manager;
 }
 
 AbstractScraper::~AbstractScraper()
@@ -116,6 +119,7 @@ void AbstractScraper::getGameData(GameEntry &game)
       ;
     }
   }
+  runFetchPlan(game);
 }
 
 void AbstractScraper::getDescription(GameEntry &game)
@@ -317,14 +321,9 @@ void AbstractScraper::getCover(GameEntry &game)
   }
   QString coverUrl = data.left(data.indexOf(coverPost)).replace("&amp;", "&");
   if(coverUrl.indexOf("http") != -1) {
-    manager.request(coverUrl);
+    addToFetchPlan(COVER, coverUrl);
   } else {
-    manager.request(baseUrl + (coverUrl.left(1) == "/"?"":"/") + coverUrl);
-  }
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.coverData = image;
+    addToFetchPlan(COVER, baseUrl + (coverUrl.left(1) == "/"?"":"/") + coverUrl);
   }
 }
 
@@ -343,14 +342,9 @@ void AbstractScraper::getScreenshot(GameEntry &game)
     }
     QString screenshotUrl = data.left(data.indexOf(screenshotPost)).replace("&amp;", "&");
     if(screenshotUrl.indexOf("http") != -1) {
-      manager.request(screenshotUrl);
+      addToFetchPlan(SCREENSHOT, screenshotUrl);
     } else {
-      manager.request(baseUrl + (screenshotUrl.left(1) == "/"?"":"/") + screenshotUrl);
-    }
-    q.exec();
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.screenshotData = image;
+      addToFetchPlan(SCREENSHOT, baseUrl + (screenshotUrl.left(1) == "/"?"":"/") + screenshotUrl);
     }
   }
 }
@@ -370,13 +364,111 @@ void AbstractScraper::getVideo(GameEntry &game)
   }
   QString videoUrl = data.left(data.indexOf(videoPost)).replace("&amp;", "&");
   if(videoUrl.indexOf("http") != -1) {
-    manager.request(videoUrl);
+    addToFetchPlan(VIDEO, videoUrl);
   } else {
-    manager.request(baseUrl + (videoUrl.left(1) == "/"?"":"/") + videoUrl);
+    addToFetchPlan(VIDEO, baseUrl + (videoUrl.left(1) == "/"?"":"/") + videoUrl);
   }
-  q.exec();
-  game.videoData = manager.getData();
-  game.videoFormat = videoUrl.right(3);
+}
+
+void AbstractScraper::setVideoData(GameEntry &game, NetReply *netReply)
+{
+  game.videoData = netReply->getData();
+  game.videoFormat = netReply->getQuery().right(3);
+}
+
+// Media urls are requested as soon as they are known, so all media for a game
+// downloads in parallel while the rest of the game data is being parsed
+void AbstractScraper::addToFetchPlan(int type, QString url)
+{
+  fetchPlan.append(QPair<int, NetReply *>(type, netComm->requestAsync(url)));
+}
+
+// Waits for all planned media downloads
+void AbstractScraper::runFetchPlan(GameEntry &game)
+{
+  QList<NetReply *> replies;
+  for(int a = 0; a < fetchPlan.length(); ++a) {
+    replies.append(fetchPlan.at(a).second);
+  }
+  netComm->waitForReplies(replies);
+  applyFetchPlan(game, fetchPlan);
+  fetchPlan.clear();
+}
+
+// Hands over the planned media downloads to someone that waits for them without
+// blocking. They are given back to applyFetchPlan once they are all finished
+QList<QPair<int, NetReply *> > AbstractScraper::takeFetchPlan()
+{
+  QList<QPair<int, NetReply *> > plan = fetchPlan;
+  fetchPlan.clear();
+  return plan;
+}
+
+// If several urls were planned for the same type, the first one that gave a
+// usable result is used
+void AbstractScraper::applyFetchPlan(GameEntry &game, const QList<QPair<int, NetReply *> > &plan)
+{
+  for(int a = 0; a < plan.length(); ++a) {
+    NetReply *netReply = plan.at(a).second;
+    switch(plan.at(a).first) {
+    case COVER:
+      if(game.coverData.isNull()) {
+	QImage image(QImage::fromData(netReply->getData()));
+	if(!image.isNull()) {
+	  game.coverData = image;
+	}
+      }
+      break;
+    case SCREENSHOT:
+      if(game.screenshotData.isNull()) {
+	QImage image(QImage::fromData(netReply->getData()));
+	if(!image.isNull()) {
+	  game.screenshotData = image;
+	}
+      }
+      break;
+    case VIDEO:
+      if(game.videoFormat.isEmpty()) {
+	setVideoData(game, netReply);
+      }
+      break;
+    default:
+      ;
+    }
+    netReply->deleteLater();
+  }
+}
+
+// The async worker shares one NetComm between all its scrapers, so the host limits
+// never make it wait for requests that only it can finish
+void AbstractScraper::setNetComm(NetComm *netComm)
+{
+  this->netComm = netComm;
+}
+
+// Only scrapers whose search replies hold all of the game data can support the
+// async worker, as it never requests the game url itself
+bool AbstractScraper::supportsAsync()
+{
+  return false;
+}
+
+// Returns the search request of a pass, or an empty string when there are no
+// more passes to try
+QString AbstractScraper::getPassQuery(const int &, const QFileInfo &, const GameEntry &)
+{
+  return "";
+}
+
+void AbstractScraper::parseSearchResults(QList<GameEntry> &, const QString &,
+					 const QByteArray &, const QString &)
+{
+}
+
+// 'data' is the reply of the search that found the game. Media downloads are added
+// to the fetch plan
+void AbstractScraper::parseGameData(GameEntry &, const QByteArray &)
+{
 }
 
 void AbstractScraper::nomNom(const QString nom, bool including)
@@ -496,7 +588,7 @@ QString AbstractScraper::getCompareName(QString baseName, QString &sqrNotes, QSt
   return baseName;
 }
 
-void AbstractScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &output, QString &marking)
+void AbstractScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &, QString &output, QString &marking)
 {
   QString searchName = getSearchName(info.completeBaseName());
   QString searchNameOrig = searchName;
@@ -553,6 +645,12 @@ void AbstractScraper::setConfig(Settings *config)
   this->config = config;
 }
 
+// The host the scraping module talks to, empty for the local modules
+QString AbstractScraper::getHost()
+{
+  return QUrl(baseUrl).host();
+}
+
 bool AbstractScraper::platformMatch(QString found, QString platform) {
   foreach(QString p, Platform::getAliases(platform)) {
     if(found.toLower() == p) {
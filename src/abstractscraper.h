@@ -45,10 +45,22 @@ public:
   virtual void getGameData(GameEntry &game);
   virtual QString getSearchName(QString baseName);
   virtual QString getCompareName(QString baseName, QString &sqrNotes, QString &parNotes);
-  virtual void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &output, QString &marking);
+  virtual void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &rom, QString &output, QString &marking);
 
   void setConfig(Settings *config);
   void loadMameMap();
+  QString getHost();
+
+  // Non-blocking interface used by the async worker. The worker makes the requests
+  // and hands the replies back to the scraper for parsing
+  virtual bool supportsAsync();
+  virtual QString getPassQuery(const int &pass, const QFileInfo &info, const GameEntry &rom);
+  virtual void parseSearchResults(QList<GameEntry> &gameEntries, const QString &query,
+				  const QByteArray &data, const QString &platform);
+  virtual void parseGameData(GameEntry &game, const QByteArray &data);
+  void setNetComm(NetComm *netComm);
+  QList<QPair<int, NetReply *> > takeFetchPlan();
+  void applyFetchPlan(GameEntry &game, const QList<QPair<int, NetReply *> > &plan);
   
 protected:
   Settings *config;
@@ -66,6 +78,11 @@ protected:
   virtual void getScreenshot(GameEntry &game);
   virtual void getVideo(GameEntry &game);
 
+  virtual void setVideoData(GameEntry &game, NetReply *netReply);
+
+  void addToFetchPlan(int type, QString url);
+  void runFetchPlan(GameEntry &game);
+
   virtual void nomNom(const QString nom, bool including = true);
 
   virtual bool platformMatch(QString found, QString platform);
@@ -111,10 +128,12 @@ protected:
   QString videoPost;
 
   NetComm manager;
+  NetComm *netComm; // Used for media downloads, 'manager' unless set otherwise
   QEventLoop q; // Event loop for use when waiting for data from NetComm.
 
 private:
   QList<QPair<QString, QString> > mameMap;
+  QList<QPair<int, NetReply *> > fetchPlan;
   
 };
 
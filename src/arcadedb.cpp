@@ -108,6 +108,13 @@ void ArcadeDB::getGameData(GameEntry &game)
       ;
     }
   }
+  runFetchPlan(game);
+
+  // Only fetch the title screen if the flyer wasn't usable
+  if(game.coverData.isNull() && !jsonObj.value("url_image_title").toString().isEmpty()) {
+    addToFetchPlan(COVER, jsonObj.value("url_image_title").toString());
+    runFetchPlan(game);
+  }
 }
 
 void ArcadeDB::getReleaseDate(GameEntry &game)
@@ -199,43 +206,24 @@ void ArcadeDB::getDescription(GameEntry &game)
   }
 }
 
-void ArcadeDB::getCover(GameEntry &game)
+void ArcadeDB::getCover(GameEntry &)
 {
-  manager.request(jsonObj.value("url_image_flyer").toString());
-  q.exec();
-  {
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.coverData = image;
-      return;
-    }
-  }
-  manager.request(jsonObj.value("url_image_title").toString());
-  q.exec();
-  {
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.coverData = image;
-      return;
-    }
-  }
+  addToFetchPlan(COVER, jsonObj.value("url_image_flyer").toString());
 }
 
-void ArcadeDB::getScreenshot(GameEntry &game)
+void ArcadeDB::getScreenshot(GameEntry &)
 {
-  manager.request(jsonObj.value("url_image_ingame").toString());
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.screenshotData = image;
-  }
+  addToFetchPlan(SCREENSHOT, jsonObj.value("url_image_ingame").toString());
 }
 
-void ArcadeDB::getVideo(GameEntry &game)
+void ArcadeDB::getVideo(GameEntry &)
 {
-  manager.request(jsonObj.value("url_video_shortplay").toString());
-  q.exec();
-  game.videoData = manager.getData();
+  addToFetchPlan(VIDEO, jsonObj.value("url_video_shortplay").toString());
+}
+
+void ArcadeDB::setVideoData(GameEntry &game, NetReply *netReply)
+{
+  game.videoData = netReply->getData();
   if(game.videoData.length() > (1024 * 500)) {
     game.videoFormat = "mp4";
   } else {
@@ -50,6 +50,7 @@ private:
   void getCover(GameEntry &game);
   void getScreenshot(GameEntry &game);
   void getVideo(GameEntry &game);
+  void setVideoData(GameEntry &game, NetReply *netReply);
   QString getSearchName(QString baseName);
 
   QJsonDocument jsonDoc;
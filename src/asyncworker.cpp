@@ -0,0 +1,180 @@
+/***************************************************************************
+ *            asyncworker.cpp
+ *
+ *  Mon Jan 22 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QTimer>
+
+#include "asyncworker.h"
+
+AsyncWorker::AsyncWorker(QSharedPointer<ScrapeQueue> scrapeQueue,
+			 QSharedPointer<WriteStage> writeStage, int maxTasks)
+  : ScraperWorker(scrapeQueue, writeStage, 0)
+{
+  this->maxTasks = (maxTasks < 1?1:maxTasks);
+  netComm = nullptr;
+  queueDone = false;
+  polling = false;
+}
+
+AsyncWorker::~AsyncWorker()
+{
+}
+
+// Only starts off the first files. From then on everything happens from the event
+// loop of the thread as the replies come in
+void AsyncWorker::run()
+{
+  // Created here so it belongs to the worker thread
+  netComm = new NetComm();
+  fillTasks();
+}
+
+// All scrapers share the NetComm, so HostGovernor only ever makes the thread wait
+// when none of its own requests are in flight
+void AsyncWorker::setupScraper(AbstractScraper *scraper)
+{
+  scraper->setNetComm(netComm);
+}
+
+// Takes new files from the queue until 'maxTasks' of them are in progress. The
+// queue is only waited on when nothing is in progress, otherwise the replies that
+// come in meanwhile would have to wait as well
+void AsyncWorker::fillTasks()
+{
+  polling = false;
+  while(!queueDone && tasks.length() < maxTasks) {
+    ScrapeJob job;
+    if(tasks.isEmpty()) {
+      if(!scrapeQueue->takeJob(job, worker)) {
+	queueDone = true;
+	break;
+      }
+    } else if(!scrapeQueue->tryTakeJob(job)) {
+      // Hashing hasn't caught up. Look again soon in case no reply comes in
+      if(!polling) {
+	polling = true;
+	QTimer::singleShot(100, this, &AsyncWorker::fillTasks);
+      }
+      break;
+    }
+    ScrapeTask *task = new ScrapeTask;
+    if(!startTask(job, *task)) {
+      delete task;
+      continue;
+    }
+    tasks.append(task);
+    nextPass(task);
+  }
+
+  if(queueDone && tasks.isEmpty() && netComm != nullptr) {
+    clearScrapers();
+    // We might be called from one of its signals, so it can't be deleted right away
+    netComm->deleteLater();
+    netComm = nullptr;
+    emit allDone();
+  }
+}
+
+void AsyncWorker::nextPass(ScrapeTask *task)
+{
+  task->pass++;
+  QString query = task->scraper->getPassQuery(task->pass, task->job.info, task->rom);
+  if(query.isEmpty()) {
+    searchDone(task);
+    return;
+  }
+  task->output.append("\033[1;35mPass " + QString::number(task->pass) + "\033[0m ");
+  addReply(netComm->requestAsync(query), task);
+}
+
+// Called when a search pass found the game or there are no more passes to try
+void AsyncWorker::searchDone(ScrapeTask *task)
+{
+  if(!matchTask(*task)) {
+    endTask(task);
+    return;
+  }
+  task->scraper->parseGameData(task->game, task->searchData);
+  task->fetchPlan = task->scraper->takeFetchPlan();
+  if(task->fetchPlan.isEmpty()) {
+    completeTask(*task);
+    endTask(task);
+    return;
+  }
+  for(int a = 0; a < task->fetchPlan.length(); ++a) {
+    addReply(task->fetchPlan.at(a).second, task);
+  }
+}
+
+void AsyncWorker::addReply(NetReply *netReply, ScrapeTask *task)
+{
+  replies.insert(netReply, task);
+  connect(netReply, &NetReply::finished, this, &AsyncWorker::replyFinished);
+}
+
+void AsyncWorker::replyFinished()
+{
+  NetReply *netReply = qobject_cast<NetReply *>(sender());
+  ScrapeTask *task = replies.take(netReply);
+  if(task == nullptr) {
+    return;
+  }
+
+  if(task->fetchPlan.isEmpty()) {
+    // Reply to a search pass
+    QByteArray data = netReply->getData();
+    task->scraper->parseSearchResults(task->gameEntries, netReply->getQuery(), data,
+				      task->platform);
+    netReply->deleteLater();
+    if(task->gameEntries.isEmpty()) {
+      nextPass(task);
+    } else {
+      task->searchData = data;
+      searchDone(task);
+    }
+  } else {
+    // A media download. The game is done once all of its media is in
+    bool allFinished = true;
+    for(int a = 0; a < task->fetchPlan.length(); ++a) {
+      if(!task->fetchPlan.at(a).second->isFinished()) {
+	allFinished = false;
+	break;
+      }
+    }
+    if(!allFinished) {
+      return;
+    }
+    task->scraper->applyFetchPlan(task->game, task->fetchPlan);
+    completeTask(*task);
+    endTask(task);
+  }
+
+  fillTasks();
+}
+
+void AsyncWorker::endTask(ScrapeTask *task)
+{
+  tasks.removeOne(task);
+  delete task;
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *            asyncworker.h
+ *
+ *  Mon Jan 22 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef ASYNCWORKER_H
+#define ASYNCWORKER_H
+
+#include "scraperworker.h"
+#include "netcomm.h"
+
+// Scrapes many files at once from a single thread. Instead of waiting for each
+// reply, every file moves on to its next step when its reply comes in, so the
+// number of requests in flight isn't bound by the number of threads. Only works
+// with scrapers that support it, see AbstractScraper::supportsAsync
+class AsyncWorker : public ScraperWorker
+{
+  Q_OBJECT
+
+public:
+  AsyncWorker(QSharedPointer<ScrapeQueue> scrapeQueue, QSharedPointer<WriteStage> writeStage,
+	      int maxTasks);
+  ~AsyncWorker();
+  void run();
+
+private slots:
+  void fillTasks();
+  void replyFinished();
+
+private:
+  void setupScraper(AbstractScraper *scraper);
+  void nextPass(ScrapeTask *task);
+  void searchDone(ScrapeTask *task);
+  void addReply(NetReply *netReply, ScrapeTask *task);
+  void endTask(ScrapeTask *task);
+
+  NetComm *netComm;
+  QList<ScrapeTask *> tasks;
+  QMap<NetReply *, ScrapeTask *> replies;
+  int maxTasks;
+  bool queueDone;
+  bool polling;
+
+};
+
+#endif // ASYNCWORKER_H
@@ -25,6 +25,7 @@
 
 #include <QDir>
 #include <QDate>
+#include <QTextStream>
 
 #include "attractmode.h"
 #include "strtools.h"
@@ -113,33 +114,27 @@ void AttractMode::setNotes(GameEntry &entry, QString baseName)
   baseName = baseNameOrig;
 }
 
-void AttractMode::assembleList(QString &finalOutput, const QList<GameEntry> &gameEntries, int)
+void AttractMode::assembleList(QIODevice &output, EntrySpool &gameEntries, int)
 {
-  finalOutput.append("#Name;Title;Emulator;CloneOf;Year;Manufacturer;Category;Players;Rotation;Control;Status;DisplayCount;DisplayType;AltRomname;AltTitle;Extra;Buttons\n");
-  foreach(GameEntry entry, gameEntries) {
-    QFileInfo emuInfo(config->emulator);
-    finalOutput.append(entry.baseName + ";" +
-		       entry.title);
+  // Buffered, so entries are written to the output a block at a time
+  QTextStream romList(&output);
+  romList.setCodec("UTF-8");
+  romList << "#Name;Title;Emulator;CloneOf;Year;Manufacturer;Category;Players;Rotation;Control;Status;DisplayCount;DisplayType;AltRomname;AltTitle;Extra;Buttons\n";
+  QFileInfo emuInfo(config->emulator);
+  QString emulator = emuInfo.completeBaseName();
+  GameEntry entry;
+  gameEntries.rewind();
+  while(gameEntries.nextEntry(entry)) {
+    romList << entry.baseName << ";" << entry.title;
     if(config->brackets) {
-      finalOutput.append((entry.parNotes != ""?" " + entry.parNotes:"") + (entry.sqrNotes != ""?" " + entry.sqrNotes:""));
+      romList << (entry.parNotes != ""?" " + entry.parNotes:"") << (entry.sqrNotes != ""?" " + entry.sqrNotes:"");
     }
-    finalOutput.append(";" +		       
-		       emuInfo.completeBaseName() + ";" +
-		       ";" +
-		       QDate::fromString(entry.releaseDate, "yyyyMMdd").toString("yyyy") + ";" +
-		       entry.publisher + ";" +
-		       entry.tags + ";" +
-		       entry.players + ";" +
-		       "0" + ";" +
-		       ";" +
-		       ";" +
-		       ";" +
-		       ";" +
-		       ";" +
-		       ";" +
-		       ";" +
-		       ";\n");
+    romList << ";" << emulator << ";" << ";" <<
+      QDate::fromString(entry.releaseDate, "yyyyMMdd").toString("yyyy") << ";" <<
+      entry.publisher << ";" << entry.tags << ";" << entry.players << ";" <<
+      "0" << ";;;;;;;;;\n";
   }
+  romList.flush();
 }
 
 void AttractMode::checkReqs()
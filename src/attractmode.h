@@ -37,7 +37,7 @@ public:
   void checkReqs();
   void skipExisting(const QString &gameListFileString, QList<GameEntry> &gameEntries,
 		    QList<QFileInfo> &inputFiles);
-  void assembleList(QString &finalOutput, const QList<GameEntry> &gameEntries, int maxDescLength);
+  void assembleList(QIODevice &output, EntrySpool &gameEntries, int maxLength);
   bool canSkip();
   QString getGameListFileName();
   QString getInputFolder();
@@ -0,0 +1,211 @@
+/***************************************************************************
+ *            binarydb.cpp
+ *
+ *  Sat Jan 20 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QFileInfo>
+
+#include "binarydb.h"
+
+#define DBMAGIC 0x534b4442
+#define DBVERSION 1
+// Magic, version, index offset and log offset
+#define HEADERSIZE 24
+#define OPADD 0
+#define OPREMOVE 1
+
+BinaryDb::BinaryDb(const QString &dbFolder)
+{
+  dbFileString = dbFolder + "/db.bin";
+  readFile.setFileName(dbFileString);
+  logFile.setFileName(dbFileString);
+  newFile.setFileName(dbFileString);
+  indexOffset = HEADERSIZE;
+  logOffset = HEADERSIZE;
+  validEnd = 0;
+}
+
+BinaryDb::~BinaryDb()
+{
+  logFile.close();
+  readFile.close();
+}
+
+bool BinaryDb::exists()
+{
+  return QFileInfo::exists(dbFileString);
+}
+
+// Starts reading the records of the index and the log from the beginning
+bool BinaryDb::rewind()
+{
+  QMutexLocker locker(&readMutex);
+  readFile.close();
+  if(!readFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&readFile);
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version >> indexOffset >> logOffset;
+  if(in.status() != QDataStream::Ok || magic != DBMAGIC || version != DBVERSION ||
+     indexOffset < HEADERSIZE || logOffset < indexOffset || !readFile.seek(indexOffset)) {
+    readFile.close();
+    return false;
+  }
+  validEnd = indexOffset;
+  return true;
+}
+
+// Reads the next complete record. A record cut short by a crash ends the log there
+bool BinaryDb::nextRecord(Resource &resource, bool &removed)
+{
+  QMutexLocker locker(&readMutex);
+  if(!readFile.isOpen() || !readFile.seek(validEnd)) {
+    return false;
+  }
+  QDataStream in(&readFile);
+  quint32 length = 0;
+  in >> length;
+  QByteArray payload = readFile.read(length);
+  if(in.status() != QDataStream::Ok || (quint32)payload.size() != length) {
+    return false;
+  }
+  QDataStream record(payload);
+  quint8 op = OPADD;
+  resource = Resource();
+  record >> op >> resource.sha1 >> resource.type >> resource.source
+	 >> resource.timestamp >> resource.valueOffset >> resource.value;
+  if(record.status() != QDataStream::Ok) {
+    return false;
+  }
+  removed = (op == OPREMOVE);
+  validEnd = readFile.pos();
+  return true;
+}
+
+// Opens the file for appending changes, leaving out anything after the last
+// complete record
+bool BinaryDb::openLog()
+{
+  logFile.close();
+  if(!logFile.open(QIODevice::ReadWrite)) {
+    return false;
+  }
+  if(validEnd >= HEADERSIZE && validEnd < logFile.size()) {
+    logFile.resize(validEnd);
+  }
+  return logFile.seek(logFile.size());
+}
+
+void BinaryDb::appendRecord(const Resource &resource, bool removed)
+{
+  if(!logFile.isOpen()) {
+    return;
+  }
+  QByteArray record = encodeRecord(resource, removed);
+  QDataStream out(&logFile);
+  out << (quint32)record.size();
+  logFile.write(record);
+  logFile.flush();
+}
+
+// True once the appended changes take up more than a quarter of the index
+bool BinaryDb::needsCompaction()
+{
+  qint64 end = (logFile.isOpen()?logFile.size():QFileInfo(dbFileString).size());
+  qint64 logBytes = end - (qint64)logOffset;
+  return !exists() || logBytes > (qint64)(logOffset - indexOffset) / 4;
+}
+
+// Starts writing a new file. It replaces the current one on 'commit'. Values must
+// be added before the index records that refer to them
+bool BinaryDb::create()
+{
+  if(!newFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  newFile.write(QByteArray(HEADERSIZE, '\0'));
+  indexOffset = HEADERSIZE;
+  return true;
+}
+
+qint64 BinaryDb::addValue(const QString &value)
+{
+  qint64 offset = newFile.pos();
+  QDataStream out(&newFile);
+  out << value;
+  return offset;
+}
+
+void BinaryDb::startIndex()
+{
+  indexOffset = newFile.pos();
+}
+
+void BinaryDb::addIndexRecord(const Resource &resource)
+{
+  QByteArray record = encodeRecord(resource, false);
+  QDataStream out(&newFile);
+  out << (quint32)record.size();
+  newFile.write(record);
+}
+
+bool BinaryDb::commit()
+{
+  logOffset = newFile.pos();
+  newFile.seek(0);
+  QDataStream out(&newFile);
+  out << (quint32)DBMAGIC << (quint32)DBVERSION << indexOffset << logOffset;
+  if(!newFile.commit()) {
+    return false;
+  }
+  // The old file is gone, values are read from the new one from now on
+  QMutexLocker locker(&readMutex);
+  readFile.close();
+  validEnd = logOffset;
+  return openLog();
+}
+
+QString BinaryDb::readValue(const qint64 &offset)
+{
+  QMutexLocker locker(&readMutex);
+  if(!readFile.isOpen() && !readFile.open(QIODevice::ReadOnly)) {
+    return QString();
+  }
+  QString value;
+  if(readFile.seek(offset)) {
+    QDataStream in(&readFile);
+    in >> value;
+  }
+  return value;
+}
+
+QByteArray BinaryDb::encodeRecord(const Resource &resource, bool removed)
+{
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out << (quint8)(removed?OPREMOVE:OPADD) << resource.sha1 << resource.type << resource.source
+      << resource.timestamp << resource.valueOffset << resource.value;
+  return record;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *            binarydb.h
+ *
+ *  Sat Jan 20 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef BINARYDB_H
+#define BINARYDB_H
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QMutex>
+
+#include "localdb.h"
+
+// Binary storage for the local db in 'db.bin', used instead of 'db.xml' when
+// 'dbFormat' is set to 'binary'. The file starts with the values of the large text
+// resources, followed by an index of length prefixed records holding everything
+// else. Startup only reads the index, the large values are read when needed.
+// Changes made during a run are appended to the end as records of their own, so
+// they survive a crash, and are folded into a new index once they add up.
+class BinaryDb
+{
+public:
+  BinaryDb(const QString &dbFolder);
+  ~BinaryDb();
+  bool exists();
+  bool rewind();
+  bool nextRecord(Resource &resource, bool &removed);
+  bool openLog();
+  void appendRecord(const Resource &resource, bool removed);
+  bool needsCompaction();
+  bool create();
+  qint64 addValue(const QString &value);
+  void startIndex();
+  void addIndexRecord(const Resource &resource);
+  bool commit();
+  QString readValue(const qint64 &offset);
+
+private:
+  static QByteArray encodeRecord(const Resource &resource, bool removed);
+  QString dbFileString;
+  QFile readFile;
+  QFile logFile;
+  QSaveFile newFile;
+  QMutex readMutex;
+  quint64 indexOffset;
+  quint64 logOffset;
+  qint64 validEnd;
+
+};
+
+#endif // BINARYDB_H
@@ -0,0 +1,120 @@
+/***************************************************************************
+ *            crc32.cpp
+ *
+ *  Tue Jan 9 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include "crc32.h"
+#include "hashkernels.h"
+
+struct Crc32Kernel {
+  QString name;
+  quint32 (*update)(quint32 crc, const uchar *data, qint64 length);
+  int granularity; // Length handed to the kernel must be a multiple of this
+};
+
+// The fastest kernel the cpu supports is picked the first time it's needed
+static Crc32Kernel &currentKernel()
+{
+  static Crc32Kernel kernel = [] {
+    Crc32Kernel best = { "table", nullptr, 1 };
+    if(HashKernels::hasPclmul()) {
+      best = { "pclmul", HashKernels::crc32Pclmul, 16 };
+    } else if(HashKernels::hasArmCrc32()) {
+      best = { "armv8-crc", HashKernels::crc32Arm, 1 };
+    }
+    return best;
+  }();
+  return kernel;
+}
+
+// Table is built once, the first time it's needed. Thread safe since C++11
+const quint32 *Crc32::getTable()
+{
+  static quint32 table[256];
+  static bool tableReady = [] {
+    for(quint32 a = 0; a < 256; ++a) {
+      quint32 c = a;
+      for(int b = 0; b < 8; ++b) {
+	c = (c & 1?0xedb88320 ^ (c >> 1):c >> 1);
+      }
+      table[a] = c;
+    }
+    return true;
+  }();
+  Q_UNUSED(tableReady);
+  return table;
+}
+
+// Start with a crc of 0 and feed it the data in as many chunks as needed
+quint32 Crc32::update(quint32 crc, const char *data, qint64 length)
+{
+  const quint32 *table = getTable();
+  crc = ~crc;
+  const uchar *bytes = (const uchar *)data;
+  // Whatever the kernel can't take goes through the table
+  Crc32Kernel &kernel = currentKernel();
+  if(kernel.update != nullptr && length >= 64) {
+    qint64 bulk = length - length % kernel.granularity;
+    crc = kernel.update(crc, bytes, bulk);
+    bytes += bulk;
+    length -= bulk;
+  }
+  for(qint64 a = 0; a < length; ++a) {
+    crc = table[(crc ^ bytes[a]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// Kernels usable on this cpu. 'table' is always available
+QList<QString> Crc32::getKernels()
+{
+  QList<QString> kernels;
+  if(HashKernels::hasPclmul()) {
+    kernels.append("pclmul");
+  }
+  if(HashKernels::hasArmCrc32()) {
+    kernels.append("armv8-crc");
+  }
+  kernels.append("table");
+  return kernels;
+}
+
+// Only meant for benchmarking, since it isn't thread safe
+bool Crc32::setKernel(const QString &name)
+{
+  if(name == "pclmul" && HashKernels::hasPclmul()) {
+    currentKernel() = { name, HashKernels::crc32Pclmul, 16 };
+  } else if(name == "armv8-crc" && HashKernels::hasArmCrc32()) {
+    currentKernel() = { name, HashKernels::crc32Arm, 1 };
+  } else if(name == "table") {
+    currentKernel() = { name, nullptr, 1 };
+  } else {
+    return false;
+  }
+  return true;
+}
+
+QString Crc32::getKernel()
+{
+  return currentKernel().name;
+}
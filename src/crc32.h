@@ -0,0 +1,48 @@
+/***************************************************************************
+ *            crc32.h
+ *
+ *  Tue Jan 9 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QString>
+
+// Standard CRC-32 as used by zip files and rom databases. Uses the carry-less
+// multiply or crc instructions of the cpu when it has them
+class Crc32
+{
+public:
+  static quint32 update(quint32 crc, const char *data, qint64 length);
+  static QList<QString> getKernels();
+  static bool setKernel(const QString &name);
+  static QString getKernel();
+
+private:
+  static const quint32 *getTable();
+
+};
+
+#endif // CRC32_H
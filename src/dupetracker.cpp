@@ -0,0 +1,124 @@
+/***************************************************************************
+ *            dupetracker.cpp
+ *
+ *  Thu Jan 18 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include <QRegularExpression>
+
+#include "dupetracker.h"
+
+DupeTracker::DupeTracker()
+{
+}
+
+// Files of a multi disk game share a key made from their compare name and their
+// parenthesis notes without the disk or side markers, for instance
+// 'Game (Europe) (Disk 1 of 3)' and 'Game (Europe) (Side B)'. CD32 and CDTV are
+// Amiga platforms, not disk numbers
+QString DupeTracker::getKey(const ScrapeJob &job, const QString &compareName,
+			    const QString &parNotes, bool groupDisks)
+{
+  if(groupDisks) {
+    QRegularExpression diskExp("\\(\\s*(?!cd32|cdtv)(?:(?:disk|disc|side)\\s*(?:[0-9]+|[a-z])\\b|cd\\s*[0-9]\\b)(?:\\s*of\\s*[0-9]+)?\\s*\\)",
+			       QRegularExpression::CaseInsensitiveOption);
+    if(parNotes.contains(diskExp)) {
+      QString notes = parNotes;
+      return "disks:" + (compareName + " " + notes.remove(diskExp)).simplified().toLower();
+    }
+  }
+  // Zips are keyed by their name, so copies with different names are only found
+  // by the checksum of the rom inside
+  if(!job.romSha1.isEmpty()) {
+    return "rom:" + job.romSha1;
+  }
+  return job.sha1;
+}
+
+// Set if the key groups the disks of a game rather than copies of a rom
+bool DupeTracker::isDiskKey(const QString &key)
+{
+  return key.startsWith("disks:");
+}
+
+// Returns SCRAPE for the first copy of a rom. Later copies return WAIT while the
+// first one is being scraped, in which case they are handed back by scraped(), and
+// COPY once it's done, with the result in 'original'
+DupeTracker::Claim DupeTracker::claim(const QString &key, const ScrapeJob &job,
+				      GameEntry &original)
+{
+  QMutexLocker locker(&dupeMutex);
+
+  if(!roms.contains(key)) {
+    roms.insert(key, DupeState());
+    return SCRAPE;
+  }
+  DupeState &state = roms[key];
+  if(!state.scraped) {
+    state.waiting.append(job);
+    return WAIT;
+  }
+  original = state.original;
+  return COPY;
+}
+
+// Stores the result of the first copy and returns the copies that waited for it
+QList<ScrapeJob> DupeTracker::scraped(const QString &key, const GameEntry &game)
+{
+  QMutexLocker locker(&dupeMutex);
+
+  DupeState &state = roms[key];
+  state.original = game;
+  // Copies link to the media files of the original, so the media data isn't kept.
+  // Tiny stand-ins keep the completeness of the copies right
+  if(!game.coverData.isNull()) {
+    state.original.coverData = QImage(1, 1, QImage::Format_ARGB32);
+  }
+  if(!game.screenshotData.isNull()) {
+    state.original.screenshotData = QImage(1, 1, QImage::Format_ARGB32);
+  }
+  state.original.videoData = "";
+  state.scraped = true;
+  QList<ScrapeJob> waiting = state.waiting;
+  state.waiting.clear();
+  return waiting;
+}
+
+// Called by the write stage once the media and db resources of a rom are on disk
+void DupeTracker::written(const QString &sha1)
+{
+  QMutexLocker locker(&dupeMutex);
+
+  writtenSha1s.insert(sha1);
+  writtenCondition.wakeAll();
+}
+
+// Copies wait for this before linking to the media of the original
+void DupeTracker::waitUntilWritten(const QString &sha1)
+{
+  QMutexLocker locker(&dupeMutex);
+
+  while(!writtenSha1s.contains(sha1)) {
+    writtenCondition.wait(&dupeMutex);
+  }
+}
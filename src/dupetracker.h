@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            dupetracker.h
+ *
+ *  Thu Jan 18 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef DUPETRACKER_H
+#define DUPETRACKER_H
+
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "gameentry.h"
+#include "scrapequeue.h"
+
+struct DupeState {
+  GameEntry original;
+  QList<ScrapeJob> waiting;
+  bool scraped = false;
+};
+
+// Keeps track of the roms in a scraping run by their rom checksum if it's known,
+// otherwise by their local db key, or by their name for games that come on
+// several disks. Only the first copy of a rom, or the
+// first disk of a game, is scraped. The others get its result, and link to its
+// media instead of having it composited and written again.
+class DupeTracker
+{
+public:
+  enum Claim { SCRAPE, WAIT, COPY };
+  DupeTracker();
+  static QString getKey(const ScrapeJob &job, const QString &compareName,
+			const QString &parNotes, bool groupDisks);
+  static bool isDiskKey(const QString &key);
+  Claim claim(const QString &key, const ScrapeJob &job, GameEntry &original);
+  QList<ScrapeJob> scraped(const QString &key, const GameEntry &game);
+  void written(const QString &sha1);
+  void waitUntilWritten(const QString &sha1);
+
+private:
+  QMap<QString, DupeState> roms;
+  QSet<QString> writtenSha1s;
+  QMutex dupeMutex;
+  QWaitCondition writtenCondition;
+
+};
+
+#endif // DUPETRACKER_H
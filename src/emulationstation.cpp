@@ -25,7 +25,6 @@
 
 #include "emulationstation.h"
 #include "xmlreader.h"
-#include "strtools.h"
 
 EmulationStation::EmulationStation()
 {
@@ -55,64 +54,50 @@ void EmulationStation::skipExisting(const QString &gameListFileString,
   }
 }
 
-void EmulationStation::assembleList(QString &finalOutput, const QList<GameEntry> &gameEntries,
+void EmulationStation::assembleList(QIODevice &output, EntrySpool &gameEntries,
 				    int maxLength)
 {
-  finalOutput.append("<?xml version=\"1.0\"?>\n<gameList>\n");
-  foreach(GameEntry entry, gameEntries) {
-    finalOutput.append("  <game>\n");
-    finalOutput.append("    <path>" + StrTools::xmlEscape(entry.path) + "</path>\n");
+  // Entries are streamed straight to the output one at a time
+  QXmlStreamWriter xml(&output);
+  xml.setAutoFormatting(true);
+  xml.setAutoFormattingIndent(2);
+  xml.writeStartDocument();
+  xml.writeStartElement("gameList");
+  GameEntry entry;
+  gameEntries.rewind();
+  while(gameEntries.nextEntry(entry)) {
+    xml.writeStartElement("game");
+    xml.writeTextElement("path", entry.path);
     if(config->brackets) {
-      finalOutput.append("    <name>" + StrTools::xmlEscape(entry.title + (entry.parNotes != ""?" " + entry.parNotes:"") + (entry.sqrNotes != ""?" " + entry.sqrNotes:"")) + "</name>\n");
+      xml.writeTextElement("name", entry.title + (entry.parNotes != ""?" " + entry.parNotes:"") + (entry.sqrNotes != ""?" " + entry.sqrNotes:""));
     } else {
-      finalOutput.append("    <name>" + StrTools::xmlEscape(entry.title) + "</name>\n");
-    }
-    if(entry.imageFile.isEmpty()) {
-      finalOutput.append("    <image />\n");
-    } else {
-      finalOutput.append("    <image>" + StrTools::xmlEscape(entry.imageFile) + "</image>\n");
+      xml.writeTextElement("name", entry.title);
     }
+    writeElement(xml, "image", entry.imageFile);
     if(!entry.videoFormat.isEmpty()) {
-      finalOutput.append("    <video>" + StrTools::xmlEscape(entry.videoFile) + "</video>\n");
-    }
-    if(entry.rating.isEmpty()) {
-      finalOutput.append("    <rating />\n");
-    } else {
-      finalOutput.append("    <rating>" + StrTools::xmlEscape(entry.rating) + "</rating>\n");
-    }
-    if(entry.description.isEmpty()) {
-      finalOutput.append("    <desc />\n");
-    } else {
-      finalOutput.append("    <desc>" + StrTools::xmlEscape(entry.description.left(maxLength)) + "</desc>\n");
+      xml.writeTextElement("video", entry.videoFile);
     }
-    if(entry.releaseDate.isEmpty()) {
-      finalOutput.append("    <releasedate />\n");
-    } else {
-      finalOutput.append("    <releasedate>" + StrTools::xmlEscape(entry.releaseDate) + "</releasedate>\n");
-    }
-    if(entry.developer.isEmpty()) {
-      finalOutput.append("    <developer />\n");
-    } else {
-      finalOutput.append("    <developer>" + StrTools::xmlEscape(entry.developer) + "</developer>\n");
-    }
-    if(entry.publisher.isEmpty()) {
-      finalOutput.append("    <publisher />\n");
-    } else {
-      finalOutput.append("    <publisher>" + StrTools::xmlEscape(entry.publisher) + "</publisher>\n");
-    }
-    if(entry.tags.isEmpty()) {
-      finalOutput.append("    <genre />\n");
-    } else {
-      finalOutput.append("    <genre>" + StrTools::xmlEscape(entry.tags) + "</genre>\n");
-    }
-    if(entry.players.isEmpty()) {
-      finalOutput.append("    <players />\n");
-    } else {
-      finalOutput.append("    <players>" + StrTools::xmlEscape(entry.players) + "</players>\n");
-    }
-    finalOutput.append("  </game>\n");
+    writeElement(xml, "rating", entry.rating);
+    writeElement(xml, "desc", entry.description.left(maxLength));
+    writeElement(xml, "releasedate", entry.releaseDate);
+    writeElement(xml, "developer", entry.developer);
+    writeElement(xml, "publisher", entry.publisher);
+    writeElement(xml, "genre", entry.tags);
+    writeElement(xml, "players", entry.players);
+    xml.writeEndElement();
+  }
+  xml.writeEndElement();
+  xml.writeEndDocument();
+}
+
+void EmulationStation::writeElement(QXmlStreamWriter &xml, const QString &name,
+				    const QString &value)
+{
+  if(value.isEmpty()) {
+    xml.writeEmptyElement(name);
+  } else {
+    xml.writeTextElement(name, value);
   }
-  finalOutput.append("</gameList>");
 }
 
 bool EmulationStation::canSkip()
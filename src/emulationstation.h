@@ -26,6 +26,8 @@
 #ifndef EMULATIONSTATION_H
 #define EMULATIONSTATION_H
 
+#include <QXmlStreamWriter>
+
 #include "abstractfrontend.h"
 
 class EmulationStation : public AbstractFrontend
@@ -34,7 +36,7 @@ class EmulationStation : public AbstractFrontend
 
 public:
   EmulationStation();
-  void assembleList(QString &finalOutput, const QList<GameEntry> &gameEntries, int maxDescLength);
+  void assembleList(QIODevice &output, EntrySpool &gameEntries, int maxLength);
   void skipExisting(const QString &gameListFileString, QList<GameEntry> &gameEntries,
 		    QList<QFileInfo> &inputFiles);
   bool canSkip();
@@ -44,6 +46,9 @@ public:
   QString getImagesFolder();
   QString getVideosFolder();
 
+private:
+  void writeElement(QXmlStreamWriter &xml, const QString &name, const QString &value);
+
 };
 
 #endif // EMULATIONSTATION_H
@@ -0,0 +1,229 @@
+/***************************************************************************
+ *            entryspool.cpp
+ *
+ *  Mon Jan 8 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <algorithm>
+
+#include <QDir>
+#include <QJsonDocument>
+
+#include "entryspool.h"
+
+// Number of keys kept in memory before they are spilled to disk as a sorted run
+#define MAXKEYS 65536
+// Number of sorted runs allowed before they are merged into one
+#define MAXRUNS 16
+
+EntrySpool::EntrySpool()
+{
+  entryFile.setFileTemplate(QDir::tempPath() + "/skyscraper-entries-XXXXXX");
+  trackPaths = false;
+  entries = 0;
+}
+
+EntrySpool::~EntrySpool()
+{
+  qDeleteAll(runStreams);
+  qDeleteAll(keyRuns);
+}
+
+// Starts over with an empty spool if it has been used before. When tracking paths,
+// adding an entry for a path that is already in the spool replaces the old entry
+bool EntrySpool::open(bool trackPaths)
+{
+  this->trackPaths = trackPaths;
+  pathOffsets.clear();
+  removedOffsets.clear();
+  qDeleteAll(runStreams);
+  qDeleteAll(keyRuns);
+  runStreams.clear();
+  keyRuns.clear();
+  runHeads.clear();
+  runHasHead.clear();
+  keys.clear();
+  entries = 0;
+  if(entryFile.isOpen()) {
+    return entryFile.resize(0);
+  }
+  return entryFile.open();
+}
+
+void EntrySpool::addEntry(const GameEntry &entry, const QString &sortKey)
+{
+  SpoolKey key;
+  key.sortKey = sortKey;
+  key.offset = entryFile.size();
+  entryFile.seek(key.offset);
+  QDataStream entryStream(&entryFile);
+  entryStream << QJsonDocument(entry.toJson()).toJson(QJsonDocument::Compact);
+  keys.append(key);
+  entries++;
+  if(trackPaths) {
+    removeEntry(entry.path);
+    pathOffsets.insert(entry.path, key.offset);
+  }
+  if(keys.length() >= MAXKEYS) {
+    spillKeys();
+  }
+}
+
+// Only works when tracking paths. The entry data stays in the file, but is skipped
+void EntrySpool::removeEntry(const QString &path)
+{
+  if(pathOffsets.contains(path)) {
+    removedOffsets.insert(pathOffsets.take(path));
+    entries--;
+  }
+}
+
+int EntrySpool::count()
+{
+  return entries;
+}
+
+// Sorts the keys currently in memory and writes them to a new run on disk
+void EntrySpool::spillKeys()
+{
+  if(keys.isEmpty()) {
+    return;
+  }
+  std::stable_sort(keys.begin(), keys.end(),
+		   [](const SpoolKey &a, const SpoolKey &b) -> bool { return a.sortKey < b.sortKey; });
+  QTemporaryFile *keyRun = new QTemporaryFile(QDir::tempPath() + "/skyscraper-keys-XXXXXX");
+  if(!keyRun->open()) {
+    printf("Couldn't create temporary file for sorting entries, exiting...\n");
+    exit(1);
+  }
+  QDataStream keyStream(keyRun);
+  foreach(SpoolKey key, keys) {
+    keyStream << key.sortKey << key.offset;
+  }
+  keyRun->flush();
+  keyRuns.append(keyRun);
+  runStreams.append(new QDataStream(keyRun));
+  runHeads.append(SpoolKey());
+  runHasHead.append(false);
+  keys.clear();
+}
+
+// Starts reading the entries in sorted order from the beginning
+void EntrySpool::rewind()
+{
+  spillKeys();
+  if(keyRuns.length() > MAXRUNS) {
+    mergeRuns();
+  }
+  entryFile.flush();
+  for(int a = 0; a < keyRuns.length(); ++a) {
+    keyRuns.at(a)->seek(0);
+    readKey(a);
+  }
+}
+
+// Merges all sorted runs into a single run, leaving out removed entries. Keeps the
+// number of open runs down when entries are added over a long time
+void EntrySpool::mergeRuns()
+{
+  QTemporaryFile *keyRun = new QTemporaryFile(QDir::tempPath() + "/skyscraper-keys-XXXXXX");
+  if(!keyRun->open()) {
+    printf("Couldn't create temporary file for sorting entries, exiting...\n");
+    exit(1);
+  }
+  QDataStream keyStream(keyRun);
+  for(int a = 0; a < keyRuns.length(); ++a) {
+    keyRuns.at(a)->seek(0);
+    readKey(a);
+  }
+  int lowest;
+  while((lowest = lowestRun()) != -1) {
+    if(!removedOffsets.contains(runHeads.at(lowest).offset)) {
+      keyStream << runHeads.at(lowest).sortKey << runHeads.at(lowest).offset;
+    }
+    readKey(lowest);
+  }
+  keyRun->flush();
+
+  qDeleteAll(runStreams);
+  qDeleteAll(keyRuns);
+  runStreams.clear();
+  keyRuns.clear();
+  runHeads.clear();
+  runHasHead.clear();
+  keyRuns.append(keyRun);
+  runStreams.append(new QDataStream(keyRun));
+  runHeads.append(SpoolKey());
+  runHasHead.append(false);
+}
+
+bool EntrySpool::readKey(int run)
+{
+  QDataStream *keyStream = runStreams.at(run);
+  if(keyStream->atEnd()) {
+    runHasHead[run] = false;
+    return false;
+  }
+  *keyStream >> runHeads[run].sortKey >> runHeads[run].offset;
+  runHasHead[run] = true;
+  return true;
+}
+
+// Merges the sorted runs, returning the entry with the lowest sort key each time
+bool EntrySpool::nextEntry(GameEntry &entry)
+{
+  int lowest;
+  while((lowest = lowestRun()) != -1) {
+    qint64 offset = runHeads.at(lowest).offset;
+    readKey(lowest);
+    if(!removedOffsets.contains(offset)) {
+      return readEntry(offset, entry);
+    }
+  }
+  return false;
+}
+
+// Returns the run with the lowest sort key at its head, or -1 when all are done
+int EntrySpool::lowestRun()
+{
+  int lowest = -1;
+  for(int a = 0; a < keyRuns.length(); ++a) {
+    if(runHasHead.at(a) &&
+       (lowest == -1 || runHeads.at(a).sortKey < runHeads.at(lowest).sortKey)) {
+      lowest = a;
+    }
+  }
+  return lowest;
+}
+
+bool EntrySpool::readEntry(const qint64 &offset, GameEntry &entry)
+{
+  if(!entryFile.seek(offset)) {
+    return false;
+  }
+  QByteArray jsonData;
+  QDataStream entryStream(&entryFile);
+  entryStream >> jsonData;
+  entry = GameEntry();
+  entry.fromJson(QJsonDocument::fromJson(jsonData).object());
+  return true;
+}
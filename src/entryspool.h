@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            entryspool.h
+ *
+ *  Mon Jan 8 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef ENTRYSPOOL_H
+#define ENTRYSPOOL_H
+
+#include <QTemporaryFile>
+#include <QDataStream>
+#include <QHash>
+#include <QSet>
+
+#include "gameentry.h"
+
+struct SpoolKey {
+  QString sortKey = "";
+  qint64 offset = 0;
+};
+
+// Keeps finished game entries in a temporary file instead of in memory. Only the
+// sort key and file offset of each entry is kept in memory, and those are spilled
+// to sorted runs on disk as well once there are many of them. Entries are read
+// back one at a time in sorted order, so gamelists can be written with flat memory
+// use no matter the size of the collection.
+class EntrySpool
+{
+public:
+  EntrySpool();
+  ~EntrySpool();
+  bool open(bool trackPaths = false);
+  void addEntry(const GameEntry &entry, const QString &sortKey);
+  void removeEntry(const QString &path);
+  int count();
+  void rewind();
+  bool nextEntry(GameEntry &entry);
+
+private:
+  void spillKeys();
+  void mergeRuns();
+  bool readKey(int run);
+  int lowestRun();
+  bool readEntry(const qint64 &offset, GameEntry &entry);
+
+  QTemporaryFile entryFile;
+  QList<SpoolKey> keys;
+  QList<QTemporaryFile *> keyRuns;
+  QList<QDataStream *> runStreams;
+  QList<SpoolKey> runHeads;
+  QList<bool> runHasHead;
+  QHash<QString, qint64> pathOffsets;
+  QSet<qint64> removedOffsets;
+  bool trackPaths;
+  int entries;
+
+};
+
+#endif // ENTRYSPOOL_H
@@ -0,0 +1,113 @@
+/***************************************************************************
+ *            fingerprint.cpp
+ *
+ *  Tue Jan 16 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include <QCryptographicHash>
+#include <QtEndian>
+
+#include "fingerprint.h"
+
+// Size of the blocks read from the beginning and end of the file
+#define EDGESIZE 65536
+// Number and size of the blocks read from in between
+#define SAMPLES 16
+#define SAMPLESIZE 4096
+
+// Returns an empty string if the file can't be read
+QString Fingerprint::getSha1(const QString &fileName)
+{
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return QString();
+  }
+  QString sha1 = getChdSha1(file);
+  if(sha1.isEmpty()) {
+    sha1 = getSampledSha1(file);
+  }
+  file.close();
+  return sha1;
+}
+
+// CHD files carry the sha1 of their uncompressed data in the header. Its position
+// depends on the header version
+QString Fingerprint::getChdSha1(QFile &file)
+{
+  QByteArray header = file.read(124);
+  if(header.length() < 16 || !header.startsWith("MComprHD")) {
+    return QString();
+  }
+  int offset = 0;
+  switch(qFromBigEndian<quint32>((const uchar *)header.constData() + 12)) {
+  case 3:
+    offset = 80;
+    break;
+  case 4:
+    offset = 48;
+    break;
+  case 5:
+    offset = 84;
+    break;
+  default:
+    return QString();
+  }
+  if(header.length() < offset + 20) {
+    return QString();
+  }
+  QByteArray sha1 = header.mid(offset, 20);
+  // An all zero sha1 means the creating tool didn't store one
+  if(sha1 == QByteArray(20, '\0')) {
+    return QString();
+  }
+  return sha1.toHex();
+}
+
+// Hashes the size, the first and last 64 KB and evenly spaced blocks in between.
+// The first 64 KB holds the volume descriptors of iso and bin disc images, which
+// contain the volume name and creation date
+QString Fingerprint::getSampledSha1(QFile &file)
+{
+  QCryptographicHash sha1(QCryptographicHash::Sha1);
+  qint64 size = file.size();
+  sha1.addData(QByteArray::number(size));
+
+  if(!file.seek(0)) {
+    return QString();
+  }
+  sha1.addData(file.read(EDGESIZE));
+  qint64 step = (size - 2 * EDGESIZE) / (SAMPLES + 1);
+  for(int a = 1; a <= SAMPLES && step > SAMPLESIZE; ++a) {
+    if(!file.seek(EDGESIZE + a * step)) {
+      return QString();
+    }
+    sha1.addData(file.read(SAMPLESIZE));
+  }
+  if(size > 2 * EDGESIZE) {
+    if(!file.seek(size - EDGESIZE)) {
+      return QString();
+    }
+    sha1.addData(file.read(EDGESIZE));
+  }
+  return sha1.result().toHex();
+}
@@ -0,0 +1,47 @@
+/***************************************************************************
+ *            fingerprint.h
+ *
+ *  Tue Jan 16 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <QFile>
+#include <QString>
+
+// Identifies files that are too big to hash in full by reading only a small part
+// of them. Unlike the file name it survives renames, so the local db entries of
+// big disc images stay connected to them.
+class Fingerprint
+{
+public:
+  static QString getSha1(const QString &fileName);
+
+private:
+  static QString getChdSha1(QFile &file);
+  static QString getSampledSha1(QFile &file);
+
+};
+
+#endif // FINGERPRINT_H
@@ -76,3 +76,62 @@ int GameEntry::completeness(bool videoEnabled)
 
   return (int)completeness;
 }
+
+// Media data is not included, only where the media was written
+QJsonObject GameEntry::toJson() const
+{
+  QJsonObject json;
+  json.insert("path", path);
+  json.insert("title", title);
+  json.insert("imageFile", imageFile);
+  json.insert("videoFile", videoFile);
+  json.insert("description", description);
+  json.insert("releaseDate", releaseDate);
+  json.insert("developer", developer);
+  json.insert("publisher", publisher);
+  json.insert("tags", tags);
+  json.insert("players", players);
+  json.insert("rating", rating);
+  json.insert("sha1", sha1);
+  json.insert("romSha1", romSha1);
+  json.insert("romMd5", romMd5);
+  json.insert("romCrc32", romCrc32);
+  json.insert("source", source);
+  json.insert("platform", platform);
+  json.insert("url", url);
+  json.insert("sqrNotes", sqrNotes);
+  json.insert("parNotes", parNotes);
+  json.insert("videoFormat", videoFormat);
+  json.insert("baseName", baseName);
+  json.insert("searchMatch", searchMatch);
+  json.insert("found", found);
+  return json;
+}
+
+void GameEntry::fromJson(const QJsonObject &json)
+{
+  path = json.value("path").toString();
+  title = json.value("title").toString();
+  imageFile = json.value("imageFile").toString();
+  videoFile = json.value("videoFile").toString();
+  description = json.value("description").toString();
+  releaseDate = json.value("releaseDate").toString();
+  developer = json.value("developer").toString();
+  publisher = json.value("publisher").toString();
+  tags = json.value("tags").toString();
+  players = json.value("players").toString();
+  rating = json.value("rating").toString();
+  sha1 = json.value("sha1").toString();
+  romSha1 = json.value("romSha1").toString();
+  romMd5 = json.value("romMd5").toString();
+  romCrc32 = json.value("romCrc32").toString();
+  source = json.value("source").toString();
+  platform = json.value("platform").toString();
+  url = json.value("url").toString();
+  sqrNotes = json.value("sqrNotes").toString();
+  parNotes = json.value("parNotes").toString();
+  videoFormat = json.value("videoFormat").toString();
+  baseName = json.value("baseName").toString();
+  searchMatch = json.value("searchMatch").toInt();
+  found = json.value("found").toBool();
+}
@@ -38,12 +38,15 @@
 #define RATING 9
 
 #include <QImage>
+#include <QJsonObject>
 
 class GameEntry
 {
 public:
   GameEntry();
   int completeness(bool videoEnabled = false);
+  QJsonObject toJson() const;
+  void fromJson(const QJsonObject &json);
   
   // Used in gamelists
   QString path = "";
@@ -61,6 +64,9 @@ public:
   // Extras needed internally
   int searchMatch = 0;
   QString sha1 = "";
+  QString romSha1 = "";
+  QString romMd5 = "";
+  QString romCrc32 = "";
   QString source = "";
   QString platform = "";
   QString url = "";
@@ -71,6 +77,12 @@ public:
   QByteArray videoData = "";
   QString videoFormat = "";
   QString baseName = "";
+  // Set if the result was taken from another rom, which has the same sha1 for
+  // copies and a different one for other disks of a game
+  QString mediaSource = ""; // Base name of the original
+  QString originalSha1 = "";
+  // Set if the rom was renamed since the last run and kept its result
+  QString movedFrom = ""; // Base name before it was renamed
   bool found = true;
 };
 
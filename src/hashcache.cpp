@@ -0,0 +1,168 @@
+/***************************************************************************
+ *            hashcache.cpp
+ *
+ *  Sun Jan 14 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+
+#include "hashcache.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#define CACHEMAGIC 0x534b4843
+// Bump this whenever the way checksums are calculated changes
+#define CACHEVERSION 5
+
+HashCache::HashCache(const QString &dbFolder)
+{
+  cacheFileString = dbFolder + "/hashcache.dat";
+}
+
+void HashCache::read()
+{
+  QFile cacheFile(cacheFileString);
+  if(!cacheFile.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  QDataStream in(&cacheFile);
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  // Checksums from another version may not be calculated the same way
+  if(magic != CACHEMAGIC || version != CACHEVERSION) {
+    return;
+  }
+  quint32 count = 0;
+  in >> count;
+  for(quint32 a = 0; a < count && in.status() == QDataStream::Ok; ++a) {
+    QString path;
+    HashRecord record;
+    in >> path >> record.size >> record.mtime >> record.inode >> record.device
+       >> record.sha1 >> record.romSha1 >> record.romMd5 >> record.romCrc32;
+    if(in.status() == QDataStream::Ok) {
+      records.insert(path, record);
+    }
+  }
+  cacheFile.close();
+  printf("Read \033[1;32m%d\033[0m cached rom checksums from '%s'\n", records.count(), cacheFileString.toStdString().c_str());
+}
+
+bool HashCache::write()
+{
+  QMutexLocker locker(&cacheMutex);
+
+  // Leave out files that have been deleted since they were hashed
+  QHash<QString, HashRecord>::iterator it = records.begin();
+  while(it != records.end()) {
+    if(QFileInfo::exists(it.key())) {
+      ++it;
+    } else {
+      it = records.erase(it);
+    }
+  }
+
+  QSaveFile cacheFile(cacheFileString);
+  if(!cacheFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QDataStream out(&cacheFile);
+  out << (quint32)CACHEMAGIC << (quint32)CACHEVERSION << (quint32)records.count();
+  for(it = records.begin(); it != records.end(); ++it) {
+    const HashRecord &record = it.value();
+    out << it.key() << record.size << record.mtime << record.inode << record.device
+	<< record.sha1 << record.romSha1 << record.romMd5 << record.romCrc32;
+  }
+  return cacheFile.commit();
+}
+
+// Fills in the checksums of 'job' if the file hasn't changed since it was cached
+bool HashCache::lookup(ScrapeJob &job, bool romDigests)
+{
+  HashRecord state = getFileState(job.info);
+
+  QMutexLocker locker(&cacheMutex);
+  if(!records.contains(job.info.absoluteFilePath())) {
+    return false;
+  }
+  const HashRecord &record = records[job.info.absoluteFilePath()];
+  if(record.size != state.size || record.mtime != state.mtime ||
+     record.inode != state.inode || record.device != state.device) {
+    return false;
+  }
+  // Cached by a scraper that didn't need the rom checksums
+  if(romDigests && record.romMd5.isEmpty()) {
+    return false;
+  }
+  job.sha1 = record.sha1;
+  job.romSha1 = record.romSha1;
+  job.romMd5 = record.romMd5;
+  job.romCrc32 = record.romCrc32;
+  return true;
+}
+
+bool HashCache::isCached(const QFileInfo &info, bool romDigests)
+{
+  ScrapeJob job;
+  job.info = info;
+  return lookup(job, romDigests);
+}
+
+void HashCache::store(const ScrapeJob &job)
+{
+  HashRecord record = getFileState(job.info);
+  record.sha1 = job.sha1;
+  record.romSha1 = job.romSha1;
+  record.romMd5 = job.romMd5;
+  record.romCrc32 = job.romCrc32;
+
+  QMutexLocker locker(&cacheMutex);
+  records.insert(job.info.absoluteFilePath(), record);
+}
+
+HashRecord HashCache::getFileState(const QFileInfo &info)
+{
+  HashRecord state;
+#ifdef Q_OS_UNIX
+  struct stat fileStat;
+  if(stat(QFile::encodeName(info.absoluteFilePath()).constData(), &fileStat) == 0) {
+    state.size = fileStat.st_size;
+#ifdef Q_OS_LINUX
+    state.mtime = (qint64)fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+#else
+    state.mtime = (qint64)fileStat.st_mtime * 1000000000;
+#endif
+    state.inode = fileStat.st_ino;
+    state.device = fileStat.st_dev;
+  }
+#else
+  state.size = info.size();
+  state.mtime = info.lastModified().toMSecsSinceEpoch() * 1000000;
+#endif
+  return state;
+}
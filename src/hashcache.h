@@ -0,0 +1,68 @@
+/***************************************************************************
+ *            hashcache.h
+ *
+ *  Sun Jan 14 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QFileInfo>
+
+#include "scrapequeue.h"
+
+struct HashRecord {
+  qint64 size = 0;
+  qint64 mtime = 0;
+  quint64 inode = 0;
+  quint64 device = 0;
+  QString sha1 = "";
+  QString romSha1 = "";
+  QString romMd5 = "";
+  QString romCrc32 = "";
+};
+
+// Checksums from earlier runs, stored in the db folder. A file is only hashed
+// again if its size, modification time, inode or device have changed.
+class HashCache
+{
+public:
+  HashCache(const QString &dbFolder);
+  void read();
+  bool write();
+  bool lookup(ScrapeJob &job, bool romDigests);
+  bool isCached(const QFileInfo &info, bool romDigests);
+  void store(const ScrapeJob &job);
+
+private:
+  static HashRecord getFileState(const QFileInfo &info);
+  QString cacheFileString;
+  QHash<QString, HashRecord> records;
+  QMutex cacheMutex;
+
+};
+
+#endif // HASHCACHE_H
@@ -0,0 +1,328 @@
+/***************************************************************************
+ *            hashkernels.cpp
+ *
+ *  Wed Jan 17 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include "hashkernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86KERNELS
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__)
+#define ARMKERNELS
+#include <arm_neon.h>
+#include <arm_acle.h>
+#include <cstring>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+#ifdef X86KERNELS
+// Four rounds of sha1 that also work out the message schedule 12 rounds ahead.
+// 'EA' receives the next message words, 'EB' saves the state for the round after
+#define SHANIROUNDS(EA, EB, M0, M1, M2, M3, F)	\
+  EA = _mm_sha1nexte_epu32(EA, M0);		\
+  EB = abcd;					\
+  M1 = _mm_sha1msg2_epu32(M1, M0);		\
+  abcd = _mm_sha1rnds4_epu32(abcd, EA, F);	\
+  M3 = _mm_sha1msg1_epu32(M3, M0);		\
+  M2 = _mm_xor_si128(M2, M0);
+
+__attribute__((target("sha,sse4.1")))
+void HashKernels::sha1ShaNi(quint32 *state, const uchar *data, qint64 blocks)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  __m128i e1, msg0, msg1, msg2, msg3;
+
+  for(qint64 block = 0; block < blocks; ++block) {
+    __m128i abcdSaved = abcd;
+    __m128i e0Saved = e0;
+
+    // Rounds 0-15 load the message
+    msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), mask);
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+    msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+    SHANIROUNDS(e1, e0, msg3, msg0, msg1, msg2, 0);
+
+    // Rounds 16-79
+    SHANIROUNDS(e0, e1, msg0, msg1, msg2, msg3, 0);
+    SHANIROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+    SHANIROUNDS(e0, e1, msg2, msg3, msg0, msg1, 1);
+    SHANIROUNDS(e1, e0, msg3, msg0, msg1, msg2, 1);
+    SHANIROUNDS(e0, e1, msg0, msg1, msg2, msg3, 1);
+    SHANIROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+    SHANIROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+    SHANIROUNDS(e1, e0, msg3, msg0, msg1, msg2, 2);
+    SHANIROUNDS(e0, e1, msg0, msg1, msg2, msg3, 2);
+    SHANIROUNDS(e1, e0, msg1, msg2, msg3, msg0, 2);
+    SHANIROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+    SHANIROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+    SHANIROUNDS(e0, e1, msg0, msg1, msg2, msg3, 3);
+    SHANIROUNDS(e1, e0, msg1, msg2, msg3, msg0, 3);
+    SHANIROUNDS(e0, e1, msg2, msg3, msg0, msg1, 3);
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e0Saved);
+    abcd = _mm_add_epi32(abcd, abcdSaved);
+    data += 64;
+  }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+// Folds 64 bytes at a time with carry-less multiplies, then reduces the result to
+// 32 bits. Constants are for the reflected crc32 polynomial 0xedb88320
+__attribute__((target("pclmul,sse4.1")))
+quint32 HashKernels::crc32Pclmul(quint32 crc, const uchar *data, qint64 length)
+{
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000LL, 0x0163cd6124LL);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i x1 = _mm_loadu_si128((const __m128i *)data);
+  __m128i x2 = _mm_loadu_si128((const __m128i *)(data + 16));
+  __m128i x3 = _mm_loadu_si128((const __m128i *)(data + 32));
+  __m128i x4 = _mm_loadu_si128((const __m128i *)(data + 48));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  data += 64;
+  length -= 64;
+
+  while(length >= 64) {
+    __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)data));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(data + 16)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(data + 32)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(data + 48)));
+    data += 64;
+    length -= 64;
+  }
+
+  // Fold the four lanes into one
+  __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  while(length >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)data)), x5);
+    data += 16;
+    length -= 16;
+  }
+
+  // Fold 128 bits to 64, then Barrett reduce to 32
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return _mm_extract_epi32(x1, 1);
+}
+
+bool HashKernels::hasShaNi()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if(__get_cpuid_max(0, nullptr) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  bool sha = ebx & (1 << 29);
+  __cpuid(1, eax, ebx, ecx, edx);
+  return sha && (ecx & (1 << 19));
+}
+
+bool HashKernels::hasPclmul()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ecx & (1 << 1)) && (ecx & (1 << 19));
+}
+#else
+void HashKernels::sha1ShaNi(quint32 *, const uchar *, qint64)
+{
+}
+
+quint32 HashKernels::crc32Pclmul(quint32 crc, const uchar *, qint64)
+{
+  return crc;
+}
+
+bool HashKernels::hasShaNi()
+{
+  return false;
+}
+
+bool HashKernels::hasPclmul()
+{
+  return false;
+}
+#endif
+
+#ifdef ARMKERNELS
+__attribute__((target("+crypto")))
+void HashKernels::sha1ArmCe(quint32 *state, const uchar *data, qint64 blocks)
+{
+  uint32x4_t abcd = vld1q_u32(state);
+  quint32 e0 = state[4];
+  const uint32x4_t k[4] = { vdupq_n_u32(0x5a827999), vdupq_n_u32(0x6ed9eba1),
+			    vdupq_n_u32(0x8f1bbcdc), vdupq_n_u32(0xca62c1d6) };
+
+  for(qint64 block = 0; block < blocks; ++block) {
+    uint32x4_t abcdSaved = abcd;
+    quint32 eSaved = e0;
+
+    // Message schedule, four words per vector
+    uint32x4_t w[20];
+    for(int a = 0; a < 4; ++a) {
+      w[a] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + a * 16)));
+    }
+    for(int a = 4; a < 20; ++a) {
+      w[a] = vsha1su1q_u32(vsha1su0q_u32(w[a - 4], w[a - 3], w[a - 2]), w[a - 1]);
+    }
+
+    for(int a = 0; a < 20; ++a) {
+      uint32x4_t wk = vaddq_u32(w[a], k[a / 5]);
+      quint32 e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+      if(a < 5) {
+	abcd = vsha1cq_u32(abcd, e0, wk);
+      } else if(a < 10 || a >= 15) {
+	abcd = vsha1pq_u32(abcd, e0, wk);
+      } else {
+	abcd = vsha1mq_u32(abcd, e0, wk);
+      }
+      e0 = e1;
+    }
+
+    abcd = vaddq_u32(abcd, abcdSaved);
+    e0 += eSaved;
+    data += 64;
+  }
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+__attribute__((target("+crc")))
+quint32 HashKernels::crc32Arm(quint32 crc, const uchar *data, qint64 length)
+{
+  while(length >= 8) {
+    quint64 word;
+    memcpy(&word, data, 8);
+    crc = __crc32d(crc, word);
+    data += 8;
+    length -= 8;
+  }
+  while(length > 0) {
+    crc = __crc32b(crc, *data);
+    data++;
+    length--;
+  }
+  return crc;
+}
+
+bool HashKernels::hasArmSha1()
+{
+#ifdef __linux__
+  return getauxval(AT_HWCAP) & HWCAP_SHA1;
+#else
+  return false;
+#endif
+}
+
+bool HashKernels::hasArmCrc32()
+{
+#ifdef __linux__
+  return getauxval(AT_HWCAP) & HWCAP_CRC32;
+#else
+  return false;
+#endif
+}
+#else
+void HashKernels::sha1ArmCe(quint32 *, const uchar *, qint64)
+{
+}
+
+quint32 HashKernels::crc32Arm(quint32 crc, const uchar *, qint64)
+{
+  return crc;
+}
+
+bool HashKernels::hasArmSha1()
+{
+  return false;
+}
+
+bool HashKernels::hasArmCrc32()
+{
+  return false;
+}
+#endif
@@ -0,0 +1,53 @@
+/***************************************************************************
+ *            hashkernels.h
+ *
+ *  Wed Jan 17 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef HASHKERNELS_H
+#define HASHKERNELS_H
+
+#include <QtGlobal>
+
+// Low level hashing functions using the sha and carry-less multiply instructions of
+// x86 and ARMv8 cpus. Each one must only be called if the matching 'has' function
+// returns true. Sha1 and Crc32 pick the best one at runtime and otherwise fall back
+// to QCryptographicHash and the crc32 table.
+class HashKernels
+{
+public:
+  // Runs the sha1 compression function on 'blocks' 64 byte blocks
+  static void sha1ShaNi(quint32 *state, const uchar *data, qint64 blocks);
+  static void sha1ArmCe(quint32 *state, const uchar *data, qint64 blocks);
+  // Updates a raw (not inverted) crc32. The pclmul kernel needs at least 64 bytes
+  // and a length that is a multiple of 16
+  static quint32 crc32Pclmul(quint32 crc, const uchar *data, qint64 length);
+  static quint32 crc32Arm(quint32 crc, const uchar *data, qint64 length);
+  static bool hasShaNi();
+  static bool hasPclmul();
+  static bool hasArmSha1();
+  static bool hasArmCrc32();
+
+};
+
+#endif // HASHKERNELS_H
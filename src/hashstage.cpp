@@ -0,0 +1,447 @@
+/***************************************************************************
+ *            hashstage.cpp
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QRunnable>
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+
+#include <cstring>
+
+#include "hashstage.h"
+#include "crc32.h"
+#include "sha1.h"
+#include "zipreader.h"
+#include "fingerprint.h"
+#include "platform.h"
+#include "platformrun.h"
+
+class HashRunner : public QRunnable
+{
+public:
+  HashRunner(HashStage *hashStage, QSharedPointer<Queue> queue,
+	     QSharedPointer<ScrapeQueue> scrapeQueue)
+  {
+    this->hashStage = hashStage;
+    this->queue = queue;
+    this->scrapeQueue = scrapeQueue;
+  }
+  void run()
+  {
+    // Jobs can come from different platforms, which may need different checksums
+    // and use different checksum caches
+    ScrapeJob job;
+    ScrapeJob next;
+    while(queue->takeEntry(job, next)) {
+      // Let the kernel fetch the next file while this one is being hashed
+      if(!next.run.isNull() && next.info.isFile() &&
+	 HashStage::readsData(next.info, next.run->romDigests) &&
+	 (next.run->hashCache.isNull() ||
+	  !next.run->hashCache->isCached(next.info, next.run->romDigests))) {
+	RomReader::prefetch(next.info.absoluteFilePath());
+      }
+      PlatformRun *platformRun = job.run.data();
+      // No need to hash the files of a platform that has been given up on
+      if(scrapeQueue->isAbandoned(platformRun)) {
+	continue;
+      }
+      if(platformRun->hashCache.isNull()) {
+	HashStage::digestFile(job, platformRun->romDigests, platformRun->config.platform, reader);
+      } else if(!platformRun->hashCache->lookup(job, platformRun->romDigests)) {
+	HashStage::digestFile(job, platformRun->romDigests, platformRun->config.platform, reader);
+	platformRun->hashCache->store(job);
+      }
+      scrapeQueue->addJob(job);
+    }
+    hashStage->hasherDone();
+  }
+
+private:
+  HashStage *hashStage;
+  QSharedPointer<Queue> queue;
+  QSharedPointer<ScrapeQueue> scrapeQueue;
+  RomReader reader;
+};
+
+// Collects the checksums of a file while it's read block by block. The rom checksums
+// are calculated on the rom as the databases know it, without copier headers and in
+// the right byte order. The local db key always covers the file as it is
+class RomDigester
+{
+public:
+  RomDigester(const QString &platform, bool romDigests, bool keyFromData, qint64 size)
+    : md5(QCryptographicHash::Md5)
+  {
+    this->platform = platform;
+    this->romDigests = romDigests;
+    this->keyFromData = keyFromData;
+    this->size = size;
+    crc = 0;
+    headerSize = -1;
+    wordSwap = 0;
+  }
+  void addBlock(const char *data, qint64 length)
+  {
+    if(headerSize == -1) {
+      Platform::getRomLayout(platform, QByteArray::fromRawData(data, qMin(length, (qint64)512)),
+			     size, headerSize, wordSwap);
+      headerLeft = headerSize;
+    }
+    if(keyFromData) {
+      keySha1.addData(data, length);
+    }
+    if(!romDigests) {
+      return;
+    }
+    if(headerLeft > 0) {
+      qint64 skip = qMin((qint64)headerLeft, length);
+      data += skip;
+      length -= skip;
+      headerLeft -= skip;
+    }
+    if(wordSwap != 0) {
+      // Blocks are always a multiple of the word size, except maybe the last one
+      swapped.resize(length);
+      char *out = swapped.data();
+      qint64 whole = length - length % wordSwap;
+      for(qint64 a = 0; a < whole; a += wordSwap) {
+	for(int b = 0; b < wordSwap; ++b) {
+	  out[a + b] = data[a + wordSwap - 1 - b];
+	}
+      }
+      memcpy(out + whole, data + whole, length - whole);
+      data = swapped.constData();
+    }
+    // When nothing needs changing the db key doubles as the rom sha1
+    if(!keyFromData || !isUnchanged()) {
+      romSha1.addData(data, length);
+    }
+    md5.addData(data, length);
+    crc = Crc32::update(crc, data, length);
+  }
+  void finish(ScrapeJob &job)
+  {
+    if(keyFromData) {
+      job.sha1 = keySha1.result().toHex();
+    }
+    if(romDigests) {
+      job.romSha1 = (keyFromData && isUnchanged()?job.sha1:QString(romSha1.result().toHex()));
+      job.romMd5 = md5.result().toHex();
+      job.romCrc32 = QString::number(crc, 16).rightJustified(8, '0');
+    }
+  }
+
+private:
+  bool isUnchanged()
+  {
+    return headerSize <= 0 && wordSwap == 0;
+  }
+  QString platform;
+  bool romDigests;
+  bool keyFromData;
+  qint64 size;
+  Sha1 keySha1;
+  Sha1 romSha1;
+  QCryptographicHash md5;
+  quint32 crc;
+  int headerSize;
+  int headerLeft;
+  int wordSwap;
+  QByteArray swapped;
+};
+
+// Which checksums are needed, and the checksum cache to use, comes from the
+// platform of each job. Without a cache every file is hashed
+HashStage::HashStage(int threads)
+{
+  this->threads = (threads < 1?1:threads);
+  runningHashers = 0;
+  pool.setMaxThreadCount(this->threads);
+}
+
+HashStage::~HashStage()
+{
+  pool.waitForDone();
+}
+
+void HashStage::start(QSharedPointer<Queue> queue, QSharedPointer<ScrapeQueue> scrapeQueue)
+{
+  this->scrapeQueue = scrapeQueue;
+  runningHashers = threads;
+  for(int a = 0; a < threads; ++a) {
+    pool.start(new HashRunner(this, queue, scrapeQueue));
+  }
+}
+
+// The last hasher to finish tells the scraper threads that no more jobs are coming
+void HashStage::hasherDone()
+{
+  QMutexLocker locker(&doneMutex);
+
+  runningHashers--;
+  if(runningHashers == 0) {
+    scrapeQueue->close();
+  }
+}
+
+// Returns true if the file contents, not just its name, need to be hashed
+bool HashStage::readsData(const QFileInfo &info, bool romDigests)
+{
+  return romDigests || useDataSha1(info);
+}
+
+// Calculates all checksums needed for the file while reading it only once
+void HashStage::digestFile(ScrapeJob &job, bool romDigests, const QString &platform,
+			   RomReader &reader)
+{
+  const QFileInfo &info = job.info;
+  bool sha1FromData = HashStage::useDataSha1(info);
+
+  // The rom databases have checksums of the rom itself, not of the zip holding it.
+  // If the zip can't be read, the checksums of the zip file are used instead
+  if(romDigests && info.suffix().toLower() == "zip") {
+    ZipReader zipReader;
+    if(zipReader.openLargestMember(info.absoluteFilePath())) {
+      RomDigester digester(platform, true, false, zipReader.getMemberSize());
+      const char *data = nullptr;
+      qint64 length = 0;
+      while((length = zipReader.readBlock(data)) > 0) {
+	digester.addBlock(data, length);
+      }
+      zipReader.close();
+      if(length == 0) {
+	digester.finish(job);
+	job.sha1 = HashStage::getNameSha1(info);
+	return;
+      }
+    }
+  }
+
+  if(sha1FromData || romDigests) {
+    RomDigester digester(platform, romDigests, sha1FromData, info.size());
+    if(reader.open(info.absoluteFilePath())) {
+      const char *data = nullptr;
+      qint64 length = 0;
+      while((length = reader.readBlock(data)) > 0) {
+	digester.addBlock(data, length);
+      }
+      reader.close();
+      if(length == -1) {
+	printf("Couldn't read rom file '%s' while calculating its checksums, now exiting...\n", info.fileName().toStdString().c_str());
+	exit(1);
+      }
+    } else {
+      printf("Couldn't calculate sha1 hash sum of rom file '%s', please check permissions and try again, now exiting...\n", info.fileName().toStdString().c_str());
+      exit(1);
+    }
+    digester.finish(job);
+  }
+
+  if(sha1FromData) {
+    return;
+  }
+  job.sha1 = HashStage::getFingerprintSha1(info);
+  if(job.sha1.isEmpty()) {
+    job.sha1 = HashStage::getNameSha1(info);
+  }
+}
+
+// Local db key of zips, scripts and files that can't be fingerprinted
+QString HashStage::getNameSha1(const QFileInfo &info)
+{
+  QCryptographicHash sha1(QCryptographicHash::Sha1);
+  sha1.addData(info.fileName().toUtf8());
+  return sha1.result().toHex();
+}
+
+// Local db key of files that are too big to hash in full, and of cue sheets, which
+// are keyed by their data track. Both used to be keyed by name. Returns an empty
+// string if the file is keyed by name
+QString HashStage::getFingerprintSha1(const QFileInfo &info)
+{
+  if(info.suffix() == "cue") {
+    // Changes to the data track alone don't invalidate the cached key of the sheet
+    QString dataTrack = getCueDataTrack(info);
+    return (dataTrack.isEmpty()?QString():Fingerprint::getSha1(dataTrack));
+  }
+  if(isContainer(info) || useDataSha1(info)) {
+    return QString();
+  }
+  return Fingerprint::getSha1(info.absoluteFilePath());
+}
+
+// Returns the file holding the first data track of a cue sheet, or an empty string
+// if there is none
+QString HashStage::getCueDataTrack(const QFileInfo &info)
+{
+  QFile cueFile(info.absoluteFilePath());
+  if(!cueFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    return QString();
+  }
+  QString trackFile = "";
+  while(!cueFile.atEnd()) {
+    QString line = QString::fromUtf8(cueFile.readLine()).trimmed();
+    if(line.startsWith("FILE ", Qt::CaseInsensitive)) {
+      // File names with spaces are quoted. The file type comes after the name
+      QString name = line.mid(5).trimmed();
+      if(name.startsWith("\"")) {
+	name = name.mid(1, name.indexOf("\"", 1) - 1);
+      } else {
+	name = name.section(' ', 0, 0);
+      }
+      trackFile = info.absoluteDir().absoluteFilePath(name);
+    } else if(line.startsWith("TRACK ", Qt::CaseInsensitive) && !trackFile.isEmpty() &&
+	      !line.contains("AUDIO", Qt::CaseInsensitive)) {
+      cueFile.close();
+      return (QFileInfo(trackFile).isFile()?trackFile:QString());
+    }
+  }
+  cueFile.close();
+  return QString();
+}
+
+bool HashStage::useDataSha1(const QFileInfo &info)
+{
+  // If file is larger than 50 MBs, use a fingerprint for sha1
+  return !isContainer(info) && info.size() <= 52428800;
+}
+
+// If file is some sort of script or a zip file, use filename for sha1
+bool HashStage::isContainer(const QFileInfo &info)
+{
+  return (info.suffix() == "uae" || info.suffix() == "cue" ||
+	  info.suffix() == "sh" || info.suffix() == "svm" ||
+	  info.suffix() == "mds" || info.suffix() == "svm" ||
+	  info.suffix() == "zip");
+}
+
+// Hashes a buffer in memory with each checksum kernel the cpu supports
+void HashStage::runKernelBenchmark()
+{
+  QByteArray testData(67108864, '\0');
+  quint32 seed = 0x12345678;
+  for(int a = 0; a < testData.length(); ++a) {
+    seed = seed * 1103515245 + 12345;
+    testData[a] = (char)(seed >> 16);
+  }
+  double testMb = testData.length() / 1048576.0;
+
+  printf("Checksum kernels on this cpu (in memory):\n");
+  QElapsedTimer timer;
+  QString bestSha1 = Sha1::getKernel();
+  for(const auto &kernel: Sha1::getKernels()) {
+    Sha1::setKernel(kernel);
+    Sha1 sha1;
+    timer.start();
+    sha1.addData(testData.constData(), testData.length());
+    sha1.result();
+    printf("  sha1  %-10s \033[1;32m%.1f MB/s\033[0m%s\n", kernel.toStdString().c_str(),
+	   testMb / (timer.nsecsElapsed() / 1000000000.0), (kernel == bestSha1?" (used)":""));
+  }
+  Sha1::setKernel(bestSha1);
+
+  QString bestCrc32 = Crc32::getKernel();
+  for(const auto &kernel: Crc32::getKernels()) {
+    Crc32::setKernel(kernel);
+    timer.start();
+    Crc32::update(0, testData.constData(), testData.length());
+    printf("  crc32 %-10s \033[1;32m%.1f MB/s\033[0m%s\n", kernel.toStdString().c_str(),
+	   testMb / (timer.nsecsElapsed() / 1000000000.0), (kernel == bestCrc32?" (used)":""));
+  }
+  Crc32::setKernel(bestCrc32);
+
+  QCryptographicHash md5(QCryptographicHash::Md5);
+  timer.start();
+  md5.addData(testData);
+  md5.result();
+  printf("  md5   %-10s \033[1;32m%.1f MB/s\033[0m (used)\n\n", "qt",
+	 testMb / (timer.nsecsElapsed() / 1000000000.0));
+}
+
+// Reads every file in 'path' twice, first with the old 1 KB QFile reads and then with
+// RomReader, and prints the throughput of each. The files are dropped from the page
+// cache before every read so the numbers reflect the actual storage
+void HashStage::runBenchmark(const QString &path)
+{
+  runKernelBenchmark();
+
+  QList<QString> files;
+  QFileInfo pathInfo(path);
+  if(pathInfo.isFile()) {
+    files.append(pathInfo.absoluteFilePath());
+  } else if(pathInfo.isDir()) {
+    QDirIterator dirIt(path, QDir::Files, QDirIterator::Subdirectories);
+    while(dirIt.hasNext()) {
+      files.append(dirIt.next());
+    }
+  }
+  if(files.isEmpty()) {
+    printf("\033[1;31mNo files found in '%s', nothing to benchmark, now exiting...\033[0m\n", path.toStdString().c_str());
+    return;
+  }
+
+  qint64 totalBytes = 0;
+  for(const auto &file: files) {
+    totalBytes += QFileInfo(file).size();
+  }
+  printf("Benchmarking sha1 hashing of %d file(s), %lld MB in total\n", files.length(), totalBytes / 1048576);
+
+  QElapsedTimer timer;
+  for(int method = 1; method <= 2; ++method) {
+    RomReader reader;
+    qint64 elapsed = 0;
+    for(const auto &file: files) {
+      RomReader::dropCache(file);
+      timer.start();
+      if(method == 1) {
+	QCryptographicHash sha1(QCryptographicHash::Sha1);
+	QFile romFile(file);
+	if(romFile.open(QIODevice::ReadOnly)) {
+	  while(!romFile.atEnd()) {
+	    sha1.addData(romFile.read(1024));
+	  }
+	  romFile.close();
+	}
+	sha1.result();
+      } else {
+	Sha1 sha1;
+	if(reader.open(file)) {
+	  const char *data = nullptr;
+	  qint64 length = 0;
+	  while((length = reader.readBlock(data)) > 0) {
+	    sha1.addData(data, length);
+	  }
+	  reader.close();
+	}
+	sha1.result();
+      }
+      elapsed += timer.nsecsElapsed();
+    }
+    double mbPerSec = (elapsed > 0?(totalBytes / 1048576.0) / (elapsed / 1000000000.0):0.0);
+    printf("%s \033[1;32m%.1f MB/s\033[0m\n", (method == 1?"Legacy 1 KB reads:    ":"Block reader + kernel:"), mbPerSec);
+  }
+}
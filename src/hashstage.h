@@ -0,0 +1,66 @@
+/***************************************************************************
+ *            hashstage.h
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef HASHSTAGE_H
+#define HASHSTAGE_H
+
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QMutex>
+
+#include "queue.h"
+#include "scrapequeue.h"
+#include "romreader.h"
+
+// First stage of the scraping pipeline. Reads the rom files and calculates their
+// checksums on its own threads while the scraper threads wait for the network.
+class HashStage
+{
+public:
+  HashStage(int threads);
+  ~HashStage();
+  void start(QSharedPointer<Queue> queue, QSharedPointer<ScrapeQueue> scrapeQueue);
+  void hasherDone();
+  static bool readsData(const QFileInfo &info, bool romDigests);
+  static void digestFile(ScrapeJob &job, bool romDigests, const QString &platform,
+			 RomReader &reader);
+  static QString getNameSha1(const QFileInfo &info);
+  static QString getFingerprintSha1(const QFileInfo &info);
+  static void runBenchmark(const QString &path);
+
+private:
+  static bool useDataSha1(const QFileInfo &info);
+  static bool isContainer(const QFileInfo &info);
+  static QString getCueDataTrack(const QFileInfo &info);
+  static void runKernelBenchmark();
+  QThreadPool pool;
+  QMutex doneMutex;
+  QSharedPointer<ScrapeQueue> scrapeQueue;
+  int threads;
+  int runningHashers;
+
+};
+
+#endif // HASHSTAGE_H
@@ -0,0 +1,164 @@
+/***************************************************************************
+ *            hostgovernor.cpp
+ *
+ *  Sat Jan 6 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QDateTime>
+
+#include "hostgovernor.h"
+
+QMutex HostGovernor::mutex;
+QWaitCondition HostGovernor::released;
+QMap<QString, HostState> HostGovernor::hosts;
+QMap<QString, HostLimits> HostGovernor::limits;
+QElapsedTimer HostGovernor::clock;
+int HostGovernor::maxTotalInFlight = 0;
+int HostGovernor::totalInFlight = 0;
+bool HostGovernor::limited = false;
+
+// Hosts without limits set here aren't limited at all. A value of 0 means no limit
+void HostGovernor::setLimits(const QString &host, const HostLimits &hostLimits)
+{
+  QMutexLocker locker(&mutex);
+  HostLimits &current = limits[host];
+  current.requestsPerSecond = (hostLimits.requestsPerSecond < 0.0?0.0:hostLimits.requestsPerSecond);
+  current.maxInFlight = (hostLimits.maxInFlight < 0?0:hostLimits.maxInFlight);
+}
+
+// Limits the requests in flight to all hosts together, 0 means no limit
+void HostGovernor::setMaxInFlight(int maxInFlight)
+{
+  QMutexLocker locker(&mutex);
+  maxTotalInFlight = (maxInFlight < 0?0:maxInFlight);
+  released.wakeAll();
+}
+
+// Returns 0 if the request may start right away, or the number of milliseconds to
+// wait before asking again. If the host, or all hosts together, have too many
+// requests in flight and 'canWait' is set, the caller is blocked until one of them
+// is released. Otherwise -1 is returned, and the caller asks again once one of its
+// own requests is done. Callers holding requests of their own must never wait,
+// since the request they are waiting for might be one that only they can release
+int HostGovernor::acquire(const QString &host, bool canWait)
+{
+  QMutexLocker locker(&mutex);
+  if(!clock.isValid()) {
+    clock.start();
+  }
+  HostLimits hostLimits = limits.value(host);
+  while(true) {
+    qint64 now = clock.elapsed();
+    HostState &state = hosts[host];
+    if(state.blockedUntil > now) {
+      limited = true;
+      return state.blockedUntil - now;
+    }
+    if((hostLimits.maxInFlight == 0 || state.inFlight < hostLimits.maxInFlight) &&
+       (maxTotalInFlight == 0 || totalInFlight < maxTotalInFlight)) {
+      break;
+    }
+    limited = true;
+    if(!canWait) {
+      return -1;
+    }
+    released.wait(&mutex);
+  }
+
+  HostState &state = hosts[host];
+  double requestsPerSecond = hostLimits.requestsPerSecond;
+  if(requestsPerSecond > 0.0) {
+    qint64 now = clock.elapsed();
+    // Token bucket allowing bursts of up to one second worth of requests
+    double burst = (requestsPerSecond < 1.0?1.0:requestsPerSecond);
+    state.tokens += (now - state.lastRefill) * requestsPerSecond / 1000.0;
+    if(state.tokens > burst) {
+      state.tokens = burst;
+    }
+    state.lastRefill = now;
+    if(state.tokens < 1.0) {
+      limited = true;
+      return (int)((1.0 - state.tokens) * 1000.0 / requestsPerSecond) + 1;
+    }
+    state.tokens -= 1.0;
+  }
+  state.inFlight++;
+  totalInFlight++;
+  return 0;
+}
+
+// Returns true if any request has been held back since last call
+bool HostGovernor::takeLimited()
+{
+  QMutexLocker locker(&mutex);
+  bool wasLimited = limited;
+  limited = false;
+  return wasLimited;
+}
+
+void HostGovernor::release(const QString &host)
+{
+  QMutexLocker locker(&mutex);
+  HostState &state = hosts[host];
+  if(state.inFlight > 0) {
+    state.inFlight--;
+    totalInFlight--;
+    released.wakeAll();
+  }
+  // Host is no longer asking us to back off, so start over with the next backoff
+  if(clock.isValid() && state.blockedUntil <= clock.elapsed()) {
+    state.backOffs = 0;
+  }
+}
+
+// Called when a host answers 429 or 503. Blocks the host for all threads for as long
+// as 'Retry-After' says, or with an exponential backoff if it isn't set
+void HostGovernor::backOff(const QString &host, const QByteArray &retryAfter)
+{
+  QMutexLocker locker(&mutex);
+  if(!clock.isValid()) {
+    clock.start();
+  }
+  HostState &state = hosts[host];
+  qint64 wait = 0;
+  if(!retryAfter.isEmpty()) {
+    bool isSeconds = false;
+    wait = retryAfter.trimmed().toLongLong(&isSeconds) * 1000;
+    if(!isSeconds) {
+      QDateTime retryTime = QDateTime::fromString(QString(retryAfter).trimmed(), Qt::RFC2822Date);
+      if(retryTime.isValid()) {
+	wait = QDateTime::currentDateTimeUtc().msecsTo(retryTime);
+      }
+    }
+  }
+  if(wait <= 0) {
+    wait = 1000 << (state.backOffs < 6?state.backOffs:6);
+  }
+  // Never let a server keep us waiting for more than 5 minutes
+  if(wait > 300000) {
+    wait = 300000;
+  }
+  state.backOffs++;
+  if(clock.elapsed() + wait > state.blockedUntil) {
+    state.blockedUntil = clock.elapsed() + wait;
+  }
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            hostgovernor.h
+ *
+ *  Sat Jan 6 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef HOSTGOVERNOR_H
+#define HOSTGOVERNOR_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <QElapsedTimer>
+
+#include "settings.h"
+
+struct HostState {
+  double tokens = 1.0;
+  qint64 lastRefill = 0;
+  int inFlight = 0;
+  qint64 blockedUntil = 0;
+  int backOffs = 0;
+};
+
+// Process wide limits for requests made to each host, and for the number of
+// requests in flight in total. Every NetComm asks here before starting a
+// request, so the limits hold no matter how many threads are scraping at the
+// same time.
+class HostGovernor
+{
+public:
+  static void setLimits(const QString &host, const HostLimits &hostLimits);
+  static void setMaxInFlight(int maxInFlight);
+  static int acquire(const QString &host, bool canWait);
+  static void release(const QString &host);
+  static void backOff(const QString &host, const QByteArray &retryAfter);
+  static bool takeLimited();
+
+private:
+  static QMutex mutex;
+  static QWaitCondition released;
+  static QMap<QString, HostState> hosts;
+  static QMap<QString, HostLimits> limits;
+  static QElapsedTimer clock;
+  static int maxTotalInFlight;
+  static int totalInFlight;
+  static bool limited;
+
+};
+
+#endif // HOSTGOVERNOR_H
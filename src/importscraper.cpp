@@ -103,7 +103,7 @@ void ImportScraper::getGameData(GameEntry &game)
   }
 }
 
-void ImportScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &, QString &)
+void ImportScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &, QString &, QString &)
 {
   data = "";
   textualFile = "";
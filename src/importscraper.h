@@ -34,7 +34,7 @@ class ImportScraper : public AbstractScraper
 
 public:
   ImportScraper();
-  void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &, QString &);
+  void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &, QString &, QString &);
   void getGameData(GameEntry &game);
   QString getCompareName(QString baseName, QString &, QString &);
   void getCover(GameEntry &game);
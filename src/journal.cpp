@@ -0,0 +1,129 @@
+/***************************************************************************
+ *            journal.cpp
+ *
+ *  Sun Jan 7 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QJsonDocument>
+#include <QJsonArray>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "journal.h"
+
+Journal::Journal(const QString &fileName)
+{
+  journalFile.setFileName(fileName);
+}
+
+Journal::~Journal()
+{
+  journalFile.close();
+}
+
+bool Journal::exists()
+{
+  return journalFile.exists();
+}
+
+// Also used to start a new journal after the last one was removed
+bool Journal::open()
+{
+  QMutexLocker locker(&journalMutex);
+  if(journalFile.isOpen()) {
+    return true;
+  }
+  return journalFile.open(QIODevice::Append);
+}
+
+// Each record is a single line of json. A record is only complete once its
+// media and db resources have been written to disk
+void Journal::addRecord(const GameEntry &entry, const int &completeness,
+			const QList<Resource> &resources)
+{
+  QJsonObject record;
+  record.insert("entry", entry.toJson());
+  record.insert("completeness", completeness);
+  QJsonArray jsonResources;
+  foreach(Resource resource, resources) {
+    QJsonObject jsonResource;
+    jsonResource.insert("sha1", resource.sha1);
+    jsonResource.insert("type", resource.type);
+    jsonResource.insert("source", resource.source);
+    jsonResource.insert("value", resource.value);
+    jsonResource.insert("timestamp", QString::number(resource.timestamp));
+    jsonResources.append(jsonResource);
+  }
+  record.insert("resources", jsonResources);
+
+  QMutexLocker locker(&journalMutex);
+  if(!journalFile.isOpen()) {
+    return;
+  }
+  journalFile.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+  journalFile.flush();
+#ifdef Q_OS_UNIX
+  // Make sure the record survives a power cut
+  fdatasync(journalFile.handle());
+#endif
+}
+
+// Reads all complete records. A line cut short by a crash is ignored
+QList<JournalRecord> Journal::readRecords()
+{
+  QList<JournalRecord> records;
+  QFile readFile(journalFile.fileName());
+  if(!readFile.open(QIODevice::ReadOnly)) {
+    return records;
+  }
+  while(!readFile.atEnd()) {
+    QJsonDocument json = QJsonDocument::fromJson(readFile.readLine());
+    if(!json.isObject()) {
+      continue;
+    }
+    JournalRecord record;
+    record.entry.fromJson(json.object().value("entry").toObject());
+    record.completeness = json.object().value("completeness").toInt();
+    foreach(QJsonValue value, json.object().value("resources").toArray()) {
+      QJsonObject jsonResource = value.toObject();
+      Resource resource;
+      resource.sha1 = jsonResource.value("sha1").toString();
+      resource.type = jsonResource.value("type").toString();
+      resource.source = jsonResource.value("source").toString();
+      resource.value = jsonResource.value("value").toString();
+      resource.timestamp = jsonResource.value("timestamp").toString().toLongLong();
+      record.resources.append(resource);
+    }
+    records.append(record);
+  }
+  readFile.close();
+  return records;
+}
+
+void Journal::remove()
+{
+  QMutexLocker locker(&journalMutex);
+  journalFile.close();
+  journalFile.remove();
+}
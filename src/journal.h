@@ -0,0 +1,61 @@
+/***************************************************************************
+ *            journal.h
+ *
+ *  Sun Jan 7 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QFile>
+#include <QMutex>
+
+#include "gameentry.h"
+#include "localdb.h"
+
+struct JournalRecord {
+  GameEntry entry;
+  int completeness = 0;
+  QList<Resource> resources;
+};
+
+// Append only log of every game finished during a scraping run. If the run is
+// interrupted, '--resume' reads it back so only the remaining files are scraped.
+class Journal
+{
+public:
+  Journal(const QString &fileName);
+  ~Journal();
+  bool exists();
+  bool open();
+  void addRecord(const GameEntry &entry, const int &completeness,
+		 const QList<Resource> &resources);
+  QList<JournalRecord> readRecords();
+  void remove();
+
+private:
+  QFile journalFile;
+  QMutex journalMutex;
+
+};
+
+#endif // JOURNAL_H
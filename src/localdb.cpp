@@ -24,17 +24,34 @@
  */
 
 #include <QFile>
+#include <QSaveFile>
 #include <QDir>
 #include <QXmlStreamReader>
 #include <QXmlStreamAttributes>
 #include <QDateTime>
 #include <QDomDocument>
+#include <QSet>
 
 #include "localdb.h"
+#include "binarydb.h"
+#include "xmlindex.h"
 
-LocalDb::LocalDb(const QString &dbFolder)
+LocalDb::LocalDb(const QString &dbFolder, const QString &dbFormat)
 {
   dbDir = QDir(dbFolder);
+  binaryDb = nullptr;
+  xmlIndex = nullptr;
+  if(dbFormat == "binary") {
+    binaryDb = new BinaryDb(dbDir.absolutePath());
+  } else {
+    xmlIndex = new XmlIndex(dbDir.absolutePath());
+  }
+}
+
+LocalDb::~LocalDb()
+{
+  delete binaryDb;
+  delete xmlIndex;
 }
 
 bool LocalDb::createFolders(const QString &scraper)
@@ -60,63 +77,193 @@ bool LocalDb::createFolders(const QString &scraper)
 
 bool LocalDb::readDb()
 {
-  bool result = false;
+  if(binaryDb == nullptr) {
+    // The side index is only used while it matches 'db.xml'
+    if(xmlIndex->rewind()) {
+      return readXmlIndex();
+    }
+    return readXml();
+  }
+  if(binaryDb->exists()) {
+    return readBinaryDb();
+  }
+  // The first time the binary format is used, the xml db is imported into it
+  if(readXml()) {
+    printf("Importing 'db.xml' into 'db.bin'. It won't be updated from now on, use '--exportdb' to get an up to date copy.\n");
+  }
+  return compactDb();
+}
 
+// Finds each resource element in the raw file. This way the offsets of the large
+// values can be kept in the side index instead of the values themselves
+bool LocalDb::readXml()
+{
   QFile dbFile(dbDir.absolutePath() + "/db.xml");
-  if(dbFile.open(QIODevice::ReadOnly)) {
-    printf("Reading and parsing local database, please wait...\n");
-    QXmlStreamReader xml(&dbFile);
-    while(!xml.atEnd()) {
-      if(xml.readNext() != QXmlStreamReader::StartElement) {
-	continue;
-      }
-      if(xml.name() != "resource") {
-	continue;
-      }
-      QXmlStreamAttributes attribs = xml.attributes();
-      if(!attribs.hasAttribute("sha1")) {
-	printf("Resource is missing 'sha1' attribute, skipping...\n");
-	continue;
+  if(!dbFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  printf("Reading and parsing local database, please wait...\n");
+  uchar *mapped = nullptr;
+  if(dbFile.size() > 0) {
+    mapped = dbFile.map(0, dbFile.size());
+  }
+  QByteArray data;
+  if(mapped != nullptr) {
+    data = QByteArray::fromRawData((const char *)mapped, dbFile.size());
+  } else {
+    data = dbFile.readAll();
+  }
+
+  int pos = 0;
+  while((pos = data.indexOf("<resource", pos)) != -1) {
+    int tagEnd = data.indexOf('>', pos);
+    if(tagEnd == -1) {
+      break;
+    }
+    // Leave out the 'resources' element
+    char next = data.at(pos + 9);
+    if(next != ' ' && next != '\t' && next != '\r' && next != '\n' && next != '/') {
+      pos = tagEnd;
+      continue;
+    }
+    bool empty = (data.at(tagEnd - 1) == '/');
+    int elementEnd = tagEnd + 1;
+    if(!empty) {
+      elementEnd = data.indexOf("</resource>", tagEnd);
+      if(elementEnd == -1) {
+	break;
       }
+      elementEnd += 11;
+    }
+    QXmlStreamReader xml(QByteArray::fromRawData(data.constData() + pos, elementEnd - pos));
+    pos = elementEnd;
+    if(!xml.readNextStartElement()) {
+      continue;
+    }
+    QXmlStreamAttributes attribs = xml.attributes();
+    if(!attribs.hasAttribute("sha1")) {
+      printf("Resource is missing 'sha1' attribute, skipping...\n");
+      continue;
+    }
 
-      Resource resource;
-      resource.sha1 = attribs.value("sha1").toString();
+    Resource resource;
+    resource.sha1 = attribs.value("sha1").toString();
 
-      if(attribs.hasAttribute("type")) {
-	resource.type = attribs.value("type").toString();
-      } else {
-	printf("Resource with sha1 '%s' is missing 'type' attribute, skipping...\n",
-	       resource.sha1.toStdString().c_str());
-	continue;
-      }
-      if(attribs.hasAttribute("source")) {
-	resource.source = attribs.value("source").toString();
-      } else {
-	resource.source = "generic";
-      }
-      if(attribs.hasAttribute("timestamp")) {
-	resource.timestamp = attribs.value("timestamp").toULong();
-      } else {
-	printf("Resource with sha1 '%s' is missing 'timestamp' attribute, skipping...\n",
-	       resource.sha1.toStdString().c_str());
-	continue;
-      }
+    if(attribs.hasAttribute("type")) {
+      resource.type = attribs.value("type").toString();
+    } else {
+      printf("Resource with sha1 '%s' is missing 'type' attribute, skipping...\n",
+	     resource.sha1.toStdString().c_str());
+      continue;
+    }
+    if(attribs.hasAttribute("source")) {
+      resource.source = attribs.value("source").toString();
+    } else {
+      resource.source = "generic";
+    }
+    if(attribs.hasAttribute("timestamp")) {
+      resource.timestamp = attribs.value("timestamp").toULong();
+    } else {
+      printf("Resource with sha1 '%s' is missing 'timestamp' attribute, skipping...\n",
+	     resource.sha1.toStdString().c_str());
+      continue;
+    }
+    if(xmlIndex != nullptr && isLazyType(resource.type) && !empty) {
+      resource.valueOffset = tagEnd;
+    } else {
       resource.value = xml.readElementText();
-      if(resource.type == "cover" || resource.type == "screenshot" || resource.type == "video") {
-	if(!QFileInfo::exists(dbDir.absolutePath() + "/" + resource.value)) {
-	  printf("Data file is missing for %s resource with sha1 '%s', skipping...\n",
-		 resource.type.toStdString().c_str(), resource.sha1.toStdString().c_str());
-	  continue;
-	}
+    }
+    if(isMediaMissing(resource)) {
+      continue;
+    }
+
+    insertResource(resource);
+  }
+  printf("Successfully parsed %d resources!\n\n", resourceCount());
+  data.clear();
+  if(mapped != nullptr) {
+    dbFile.unmap(mapped);
+  }
+  dbFile.close();
+  if(xmlIndex != nullptr) {
+    writeXmlIndex();
+  }
+  return true;
+}
+
+bool LocalDb::readXmlIndex()
+{
+  printf("Reading local database index, please wait...\n");
+  Resource resource;
+  while(xmlIndex->nextResource(resource)) {
+    if(isMediaMissing(resource)) {
+      continue;
+    }
+    insertResource(resource);
+  }
+  printf("Successfully read %d resources!\n\n", resourceCount());
+  return true;
+}
+
+// Writes the side index for 'db.xml' as it is on disk now
+void LocalDb::writeXmlIndex()
+{
+  if(!xmlIndex->create()) {
+    return;
+  }
+  foreach(const RomResources &romResources, resources) {
+    foreach(const QList<Resource> &typeResources, romResources) {
+      foreach(const Resource &resource, typeResources) {
+	xmlIndex->addResource(resource);
       }
+    }
+  }
+  xmlIndex->commit();
+}
+
+// Descriptions make up most of a db, so they are only read when a game needs them
+bool LocalDb::isLazyType(const QString &type)
+{
+  return type == "description";
+}
+
+bool LocalDb::isMediaMissing(const Resource &resource)
+{
+  if(resource.type == "cover" || resource.type == "screenshot" || resource.type == "video") {
+    if(!QFileInfo::exists(dbDir.absolutePath() + "/" + resource.value)) {
+      printf("Data file is missing for %s resource with sha1 '%s', skipping...\n",
+	     resource.type.toStdString().c_str(), resource.sha1.toStdString().c_str());
+      return true;
+    }
+  }
+  return false;
+}
 
-      resources.append(resource);
+bool LocalDb::readBinaryDb()
+{
+  printf("Reading local database index, please wait...\n");
+  if(!binaryDb->rewind()) {
+    printf("\033[1;31mLocal database 'db.bin' in '%s' is damaged or from another version of Skyscraper. Remove it to import 'db.xml' again, now exiting...\033[0m\n", dbDir.absolutePath().toStdString().c_str());
+    exit(1);
+  }
+  Resource resource;
+  bool removed = false;
+  while(binaryDb->nextRecord(resource, removed)) {
+    if(removed) {
+      removeResource(resource);
+      continue;
     }
-    result = true;
-    printf("Successfully parsed %d resources!\n\n", resources.length());
-    dbFile.close();
+    if(isMediaMissing(resource)) {
+      continue;
+    }
+    insertResource(resource);
   }
-  return result;
+  // From now on every change is appended to the file as it happens
+  if(!binaryDb->openLog()) {
+    printf("\033[1;33mCouldn't open 'db.bin' for writing, changes won't be saved!\033[0m\n");
+  }
+  printf("Successfully read %d resources!\n\n", resourceCount());
+  return true;
 }
 
 void LocalDb::readPriorities()
@@ -168,30 +315,117 @@ void LocalDb::readPriorities()
 
 bool LocalDb::writeDb()
 {
-  bool result = false;
+  if(binaryDb == nullptr) {
+    return writeXml();
+  }
+  // Changes are already on disk, they are only folded into the index once they add up
+  if(!binaryDb->needsCompaction()) {
+    return true;
+  }
+  return compactDb();
+}
 
-  QFile dbFile(dbDir.absolutePath() + "/db.xml");
-  if(dbFile.open(QIODevice::WriteOnly)) {
-    printf("Writing %d resources to local database, please wait... ", resources.length());
-    QXmlStreamWriter xml(&dbFile);
-    xml.setAutoFormatting(true);
-    xml.writeStartDocument();
-    xml.writeStartElement("resources");
-    foreach(Resource resource, resources) {
-      xml.writeStartElement("resource");
-      xml.writeAttribute("sha1", resource.sha1);
-      xml.writeAttribute("type", resource.type);
-      xml.writeAttribute("source", resource.source);
-      xml.writeAttribute("timestamp", QString::number(resource.timestamp));
-      xml.writeCharacters(resource.value);
-      xml.writeEndElement();
-    }
-    xml.writeEndDocument();
-    result = true;
-    printf("\033[1;32mSuccess!\033[0m\n");
-    dbFile.close();
-  }
-  return result;
+// Writes the db as xml no matter which format is used
+bool LocalDb::exportDb()
+{
+  return writeXml();
+}
+
+bool LocalDb::writeXml()
+{
+  QWriteLocker locker(&dbLock);
+
+  // The current file stays in place until the new one is complete, since large
+  // values are still read from it while writing
+  QSaveFile dbFile(dbDir.absolutePath() + "/db.xml");
+  if(!dbFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  printf("Writing %d resources to local database, please wait... ", resourceCount());
+  QHash<QString, RomResources> written = resources;
+  QXmlStreamWriter xml(&dbFile);
+  xml.setAutoFormatting(true);
+  xml.writeStartDocument();
+  xml.writeStartElement("resources");
+  // Roms are written in sha1 order, so the file doesn't change needlessly between runs
+  QStringList sha1s = written.keys();
+  sha1s.sort();
+  foreach(QString sha1, sha1s) {
+    RomResources &romResources = written[sha1];
+    for(RomResources::iterator typeIt = romResources.begin(); typeIt != romResources.end(); ++typeIt) {
+      for(int a = 0; a < typeIt->length(); ++a) {
+	Resource &resource = (*typeIt)[a];
+	xml.writeStartElement("resource");
+	xml.writeAttribute("sha1", resource.sha1);
+	xml.writeAttribute("type", resource.type);
+	xml.writeAttribute("source", resource.source);
+	xml.writeAttribute("timestamp", QString::number(resource.timestamp));
+	// The start tag is closed along with the characters
+	qint64 tagEnd = dbFile.pos();
+	xml.writeCharacters(getValue(resource));
+	if(xmlIndex != nullptr && isLazyType(resource.type)) {
+	  resource.value = "";
+	  resource.valueOffset = tagEnd;
+	}
+	xml.writeEndElement();
+      }
+    }
+  }
+  xml.writeEndDocument();
+  if(!dbFile.commit()) {
+    printf("\033[1;31mFailed!\033[0m\n");
+    return false;
+  }
+  // Large values are read from the new file from now on
+  if(xmlIndex != nullptr) {
+    resources = written;
+    writeXmlIndex();
+  }
+  printf("\033[1;32mSuccess!\033[0m\n");
+  return true;
+}
+
+// Writes a new 'db.bin' with every resource in its index and no appended changes.
+// Large values are written ahead of the index, so they're skipped at startup
+bool LocalDb::compactDb()
+{
+  QWriteLocker locker(&dbLock);
+  printf("Compacting %d resources in local database, please wait... ", resourceCount());
+  if(!binaryDb->create()) {
+    printf("\033[1;31mFailed!\033[0m\n");
+    return false;
+  }
+  QHash<QString, RomResources> compacted = resources;
+  QHash<QString, RomResources>::iterator romIt;
+  RomResources::iterator typeIt;
+  for(romIt = compacted.begin(); romIt != compacted.end(); ++romIt) {
+    for(typeIt = romIt->begin(); typeIt != romIt->end(); ++typeIt) {
+      if(!isLazyType(typeIt.key())) {
+	continue;
+      }
+      for(int a = 0; a < typeIt->length(); ++a) {
+	Resource &resource = (*typeIt)[a];
+	resource.valueOffset = binaryDb->addValue(getValue(resource));
+	resource.value = "";
+      }
+    }
+  }
+  binaryDb->startIndex();
+  foreach(const RomResources &romResources, compacted) {
+    foreach(const QList<Resource> &typeResources, romResources) {
+      foreach(const Resource &resource, typeResources) {
+	binaryDb->addIndexRecord(resource);
+      }
+    }
+  }
+  if(!binaryDb->commit()) {
+    printf("\033[1;31mFailed!\033[0m\n");
+    return false;
+  }
+  // Values that were read or added during the run are left on disk again
+  resources = compacted;
+  printf("\033[1;32mSuccess!\033[0m\n");
+  return true;
 }
 
 // This verifies all attached media files and deletes those that have no entry in the db
@@ -201,7 +435,8 @@ void LocalDb::cleanDb()
 
   printf("Starting cleaning run on local database, please wait...\n");
 
-  if(!QFileInfo::exists(dbDir.absolutePath() + "/db.xml")) {
+  if(!QFileInfo::exists(dbDir.absolutePath() + "/db.xml") &&
+     !QFileInfo::exists(dbDir.absolutePath() + "/db.bin")) {
     printf("'db.xml' not found, db cleaning cancelled...\n");
     return;
   }
@@ -242,19 +477,15 @@ void LocalDb::cleanDb()
 
 void LocalDb::verifyResources(QDirIterator &dirIt, int &deleted, int &noDelete, QString resType)
 {
+  QSet<QString> fileNames;
+  foreach(const RomResources &romResources, resources) {
+    foreach(const Resource &resource, romResources.value(resType)) {
+      fileNames.insert(QFileInfo(dbDir.absolutePath() + "/" + resource.value).fileName());
+    }
+  }
   while(dirIt.hasNext()) {
     QFileInfo fileInfo(dirIt.next());
-    bool valid = false;
-    foreach(Resource resource, resources) {
-      if(resource.type == resType) {
-	QFileInfo resInfo(dbDir.absolutePath() + "/" + resource.value);
-	if(fileInfo.fileName() == resInfo.fileName()) {
-	  valid = true;
-	  break;
-	}
-      }
-    }
-    if(!valid) {
+    if(!fileNames.contains(fileInfo.fileName())) {
       printf("No resource entry for '%s', deleting... ",
 	     fileInfo.fileName().toStdString().c_str());
       if(QFile::remove(fileInfo.absoluteFilePath())) {
@@ -279,31 +510,27 @@ void LocalDb::mergeDb(LocalDb &srcDb, bool overwrite, const QString &srcDbFolder
   int resMerged = 0;
 
   foreach(Resource srcResource, srcResources) {
-    bool resExists = false;
-    for(int a = 0; a < resources.length(); ++a) {
-      if(resources.at(a).sha1 == srcResource.sha1 && resources.at(a).type == srcResource.type) {
-	if(overwrite) {
-	  resources.removeAt(a);
-	} else {
-	  resExists = true;
-	}
-      }
+    bool resExists = resources.value(srcResource.sha1).contains(srcResource.type);
+    if(resExists && !overwrite) {
+      continue;
     }
-    if(!resExists) {
-      if(srcResource.type == "cover" || srcResource.type == "screenshot" ||
-	 srcResource.type == "video") {
-	if(!QFile::copy(srcDbDir.absolutePath() + "/" + srcResource.value,
-			dbDir.absolutePath() + "/" + srcResource.value)) {
-	  continue;
-	}
+    if(srcResource.type == "cover" || srcResource.type == "screenshot" ||
+       srcResource.type == "video") {
+      if(!QFile::copy(srcDbDir.absolutePath() + "/" + srcResource.value,
+		      dbDir.absolutePath() + "/" + srcResource.value)) {
+	continue;
       }
-      if(overwrite) {
-	resUpdated++;
-      } else {
-	resMerged++;
+    }
+    if(overwrite) {
+      // Replaces the resources of all sources for this type
+      foreach(const Resource &resource, resources.value(srcResource.sha1).value(srcResource.type)) {
+	removeResource(resource);
       }
-      resources.append(srcResource);
+      resUpdated++;
+    } else {
+      resMerged++;
     }
+    insertResource(srcResource);
   }
   printf("Successfully updated %d resource(s) in local database!\n", resUpdated);
   printf("Successfully merged %d resource(s) into local database!\n\n", resMerged);
@@ -311,12 +538,99 @@ void LocalDb::mergeDb(LocalDb &srcDb, bool overwrite, const QString &srcDbFolder
 
 QList<Resource> LocalDb::getResources()
 {
-  return resources;
+  QList<Resource> allResources;
+  foreach(const RomResources &romResources, resources) {
+    foreach(const QList<Resource> &typeResources, romResources) {
+      foreach(Resource resource, typeResources) {
+	resource.value = getValue(resource);
+	resource.valueOffset = -1;
+	allResources.append(resource);
+      }
+    }
+  }
+  return allResources;
+}
+
+// Reads the value from 'db.bin' or 'db.xml' if it was left there
+QString LocalDb::getValue(const Resource &resource)
+{
+  if(resource.valueOffset == -1) {
+    return resource.value;
+  }
+  if(binaryDb != nullptr) {
+    return binaryDb->readValue(resource.valueOffset);
+  }
+  return xmlIndex->readValue(resource.valueOffset);
+}
+
+int LocalDb::resourceCount()
+{
+  int count = 0;
+  foreach(const RomResources &romResources, resources) {
+    foreach(const QList<Resource> &typeResources, romResources) {
+      count += typeResources.length();
+    }
+  }
+  return count;
+}
+
+// Index of the resource from 'source' in the resources of a type, or -1
+static int findSource(const QList<Resource> &typeResources, const QString &source)
+{
+  for(int a = 0; a < typeResources.length(); ++a) {
+    if(typeResources.at(a).source == source) {
+      return a;
+    }
+  }
+  return -1;
+}
+
+// True if there's a resource with the same sha1, type and source
+bool LocalDb::hasResource(const Resource &resource)
+{
+  return findSource(resources.value(resource.sha1).value(resource.type), resource.source) != -1;
+}
+
+void LocalDb::insertResource(const Resource &resource)
+{
+  resources[resource.sha1][resource.type].append(resource);
+  if(binaryDb != nullptr) {
+    binaryDb->appendRecord(resource, false);
+  }
+}
+
+// Removes the resource with the same sha1, type and source
+void LocalDb::removeResource(const Resource &resource)
+{
+  QHash<QString, RomResources>::iterator romIt = resources.find(resource.sha1);
+  if(romIt == resources.end()) {
+    return;
+  }
+  RomResources::iterator typeIt = romIt->find(resource.type);
+  if(typeIt == romIt->end()) {
+    return;
+  }
+  int index = findSource(*typeIt, resource.source);
+  if(index == -1) {
+    return;
+  }
+  if(binaryDb != nullptr) {
+    binaryDb->appendRecord(typeIt->at(index), true);
+  }
+  typeIt->removeAt(index);
+  if(typeIt->isEmpty()) {
+    romIt->erase(typeIt);
+    if(romIt->isEmpty()) {
+      resources.erase(romIt);
+    }
+  }
 }
     
-void LocalDb::addResources(GameEntry &entry, const bool &update)
+// Returns the resources that were actually added to the db
+QList<Resource> LocalDb::addResources(GameEntry &entry, const bool &update)
 {
   QString dbAbsolutePath = dbDir.absolutePath();
+  QList<Resource> added;
 
   if(entry.source.isEmpty()) {
     printf("Something is wrong, resource with sha1 '%s' has no source, exiting...\n",
@@ -332,224 +646,313 @@ void LocalDb::addResources(GameEntry &entry, const bool &update)
     if(entry.title != "") {
       resource.type = "title";
       resource.value = entry.title;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.platform != "") {
       resource.type = "platform";
       resource.value = entry.platform;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.description != "") {
       resource.type = "description";
       resource.value = entry.description;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.publisher != "") {
       resource.type = "publisher";
       resource.value = entry.publisher;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.developer != "") {
       resource.type = "developer";
       resource.value = entry.developer;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.players != "") {
       resource.type = "players";
       resource.value = entry.players;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.tags != "") {
       resource.type = "tags";
       resource.value = entry.tags;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.rating != "") {
       resource.type = "rating";
       resource.value = entry.rating;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.releaseDate != "") {
       resource.type = "releasedate";
       resource.value = entry.releaseDate;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(entry.videoData != "" && entry.videoFormat != "") {
       resource.type = "video";
       resource.value = "videos/" + entry.source + "/"  + entry.sha1 + "." + entry.videoFormat;
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(!entry.coverData.isNull()) {
       resource.type = "cover";
       resource.value = "covers/" + entry.source + "/" + entry.sha1 + ".png";
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
     if(!entry.screenshotData.isNull()) {
       resource.type = "screenshot";
       resource.value = "screenshots/" + entry.source + "/"  + entry.sha1 + ".png";
-      addResource(resource, entry, dbAbsolutePath, update);
+      if(addResource(resource, entry, dbAbsolutePath, update)) {
+	added.append(resource);
+      }
     }
   }
+  return added;
 }
 
-void LocalDb::addResource(const Resource &resource, GameEntry &entry,
+bool LocalDb::addResource(const Resource &resource, GameEntry &entry,
 			  const QString &dbAbsolutePath, const bool &update)
 {
-  QMutexLocker locker(&dbMutex);
-
-  bool notFound = true;
-  for(int a = 0; a < resources.length(); ++a) {
-    if(resources.at(a).sha1 == resource.sha1 &&
-       resources.at(a).type == resource.type &&
-       resources.at(a).source == resource.source) {
-      if(update) {
-	resources.removeAt(a);
-      } else {
-	notFound = false;
-      }
-      break;
+  // Media is scaled and written without holding the lock, so other threads can use
+  // the db in the meantime
+  if(!update) {
+    QReadLocker locker(&dbLock);
+    if(hasResource(resource)) {
+      return false;
     }
   }
-  if(notFound) {
-    bool okToAppend = true;
-    if(resource.type == "cover") {
-      // Restrict size of cover to save space
-      if(entry.coverData.height() >= 512) {
-	entry.coverData = entry.coverData.scaledToHeight(512, Qt::SmoothTransformation);
-      }
-      if(!entry.coverData.save(dbAbsolutePath + "/" + resource.value)) {
-	okToAppend = false;
-      }
-    } else if(resource.type == "screenshot") {
-      // Restrict size of screenshot to save space
-      if(entry.screenshotData.width() >= 640) {
-	entry.screenshotData = entry.screenshotData.scaledToWidth(640, Qt::SmoothTransformation);
-      }
-      if(!entry.screenshotData.save(dbAbsolutePath + "/" + resource.value)) {
-	okToAppend = false;
-      }
-    } else if(resource.type == "video") {
-      QFile videoFile(dbAbsolutePath + "/" + resource.value);
-      if(videoFile.open(QIODevice::WriteOnly)) {
-	videoFile.write(entry.videoData);
-	videoFile.close();
-      } else {
-	okToAppend = false;
-      }
-    }
+  if(!saveMedia(resource, entry, dbAbsolutePath)) {
+    return false;
+  }
 
-    if(okToAppend) {
-      resources.append(resource);
+  QWriteLocker locker(&dbLock);
+  if(update) {
+    removeResource(resource);
+  } else if(hasResource(resource)) {
+    // Another thread added it while the media was written
+    return false;
+  }
+  insertResource(resource);
+  return true;
+}
+
+// Scales and encodes the media of a resource and writes it to the db folder. The
+// file is replaced in one go once it's safely on disk, so the index never refers
+// to a half written file. Other resource types have nothing to write
+bool LocalDb::saveMedia(const Resource &resource, GameEntry &entry, const QString &dbAbsolutePath)
+{
+  if(resource.type != "cover" && resource.type != "screenshot" && resource.type != "video") {
+    return true;
+  }
+  QSaveFile mediaFile(dbAbsolutePath + "/" + resource.value);
+  if(!mediaFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  if(resource.type == "cover") {
+    // Restrict size of cover to save space
+    if(entry.coverData.height() >= 512) {
+      entry.coverData = entry.coverData.scaledToHeight(512, Qt::SmoothTransformation);
     }
-    
+    if(!entry.coverData.save(&mediaFile, "png")) {
+      mediaFile.cancelWriting();
+    }
+  } else if(resource.type == "screenshot") {
+    // Restrict size of screenshot to save space
+    if(entry.screenshotData.width() >= 640) {
+      entry.screenshotData = entry.screenshotData.scaledToWidth(640, Qt::SmoothTransformation);
+    }
+    if(!entry.screenshotData.save(&mediaFile, "png")) {
+      mediaFile.cancelWriting();
+    }
+  } else if(resource.type == "video") {
+    if(mediaFile.write(entry.videoData) != entry.videoData.size()) {
+      mediaFile.cancelWriting();
+    }
+  }
+  return mediaFile.commit();
+}
+
+// Puts back resources recorded in a run journal. Their media files are already in
+// the db folder, so only the entries are added
+void LocalDb::restoreResources(const QList<Resource> &restored)
+{
+  QWriteLocker locker(&dbLock);
+
+  foreach(Resource resource, restored) {
+    removeResource(resource);
+    insertResource(resource);
   }
 }
 
 bool LocalDb::hasSha1(const QString &sha1)
 {
-  // Copy data before iterating to make thread safe
-  QList<Resource> tmpResources = resources;
-  foreach(Resource res, tmpResources) {
-    if(res.sha1 == sha1) {
-      return true;
+  QReadLocker locker(&dbLock);
+
+  return resources.contains(sha1);
+}
+
+// Moves all resources from one key to another. Media files keep their names since
+// the resources refer to them by path. Returns the number of resources moved
+int LocalDb::rekeyResources(const QString &oldSha1, const QString &newSha1)
+{
+  QWriteLocker locker(&dbLock);
+
+  int moved = 0;
+  if(oldSha1 == newSha1) {
+    return moved;
+  }
+  foreach(const QList<Resource> &typeResources, resources.value(oldSha1)) {
+    foreach(Resource resource, typeResources) {
+      removeResource(resource);
+      resource.sha1 = newSha1;
+      insertResource(resource);
+      moved++;
     }
   }
-  return false;
+  return moved;
 }
 
-void LocalDb::fillBlanks(GameEntry &entry)
+// Gives 'toSha1' the resources 'fromSha1' has from 'source'. Existing ones are only
+// replaced if 'update' is set. Media resources point to the same files as those of
+// 'fromSha1'. Returns the resources added
+QList<Resource> LocalDb::copyResources(const QString &fromSha1, const QString &toSha1,
+				       const QString &source, const bool &update)
 {
-  // Copy data before iterating to make thread safe
-  QList<Resource> tmpResources = resources;
-  QList<Resource> sha1Resources;
-  // Find all resources related to this particular rom
-  foreach(Resource resource, tmpResources) {
-    if(entry.sha1 == resource.sha1) {
-      sha1Resources.append(resource);
+  QWriteLocker locker(&dbLock);
+
+  QList<Resource> added;
+  foreach(const QList<Resource> &typeResources, resources.value(fromSha1)) {
+    int index = findSource(typeResources, source);
+    if(index == -1) {
+      continue;
+    }
+    Resource copy = typeResources.at(index);
+    copy.sha1 = toSha1;
+    copy.value = getValue(copy);
+    copy.valueOffset = -1;
+    if(hasResource(copy)) {
+      if(!update) {
+	continue;
+      }
+      removeResource(copy);
     }
+    added.append(copy);
   }
+  foreach(const Resource &copy, added) {
+    insertResource(copy);
+  }
+  return added;
+}
+
+void LocalDb::fillBlanks(GameEntry &entry)
+{
+  // Only the resources of this rom are copied, the media is loaded without the lock
+  dbLock.lockForRead();
+  RomResources romResources = resources.value(entry.sha1);
+  dbLock.unlock();
 
   {
     QString type = "title";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.title = result;
     }
   }
   {
     QString type = "platform";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.platform = result;
     }
   }
   {
     QString type = "description";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.description = result;
     }
   }
   {
     QString type = "publisher";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.publisher = result;
     }
   }
   {
     QString type = "developer";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.developer = result;
     }
   }
   {
     QString type = "players";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.players = result;
     }
   }
   {
     QString type = "tags";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.tags = result;
     }
   }
   {
     QString type = "rating";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.rating = result;
     }
   }
   {
     QString type = "releasedate";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.releaseDate = result;
     }
   }
   {
     QString type = "cover";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.coverData = QImage(dbDir.absolutePath() + "/" + result);
     }
   }
   {
     QString type = "screenshot";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       entry.screenshotData = QImage(dbDir.absolutePath() + "/" + result);
     }
   }
   {
     QString type = "video";
     QString result = "";
-    if(fillType(type, sha1Resources, result)) {
+    if(fillType(type, romResources, result)) {
       QFileInfo info(dbDir.absolutePath() + "/" + result);
       QFile videoFile(info.absoluteFilePath());
       if(videoFile.open(QIODevice::ReadOnly)) {
@@ -561,14 +964,9 @@ void LocalDb::fillBlanks(GameEntry &entry)
   }
 }
 
-bool LocalDb::fillType(QString &type, QList<Resource> &sha1Resources, QString &result)
+bool LocalDb::fillType(QString &type, const RomResources &romResources, QString &result)
 {
-  QList<Resource> typeResources;
-  foreach(Resource resource, sha1Resources) {
-    if(resource.type == type) {
-      typeResources.append(resource);
-    }
-  }
+  QList<Resource> typeResources = romResources.value(type);
   if(typeResources.isEmpty()) {
     return false;
   }
@@ -576,19 +974,21 @@ bool LocalDb::fillType(QString &type, QList<Resource> &sha1Resources, QString &r
     for(int a = 0; a < prioMap.value(type).length(); ++a) {
       foreach(Resource resource, typeResources) {
 	if(resource.source == prioMap.value(type).at(a)) {
-	  result = resource.value;
+	  result = getValue(resource);
 	  return true;
 	}
       }
     }
   }
   qint64 newest = 0;
+  Resource newestResource;
   foreach(Resource resource, typeResources) {
     if(resource.timestamp >= newest) {
       newest = resource.timestamp;
-      result = resource.value;
+      newestResource = resource;
     }
   }  
+  result = getValue(newestResource);
   
   return true;
 }
@@ -596,7 +996,7 @@ bool LocalDb::fillType(QString &type, QList<Resource> &sha1Resources, QString &r
 
 void LocalDb::printResources()
 {
-  foreach(Resource resource, resources) {
+  foreach(Resource resource, getResources()) {
     printf("--- sha1: '%s' ---\ntype: '%s'\nsource: '%s'\ntimestamp: '%s'\nvalue: '%s'\n", resource.sha1.toStdString().c_str(), resource.type.toStdString().c_str(), resource.source.toStdString().c_str(), QString::number(resource.timestamp).toStdString().c_str(), resource.value.toStdString().c_str());
   }
 }
@@ -28,9 +28,10 @@
 
 #include <QObject>
 #include <QString>
-#include <QMutex>
+#include <QReadWriteLock>
 #include <QDirIterator>
 #include <QMap>
+#include <QHash>
 
 #include "gameentry.h"
 
@@ -40,36 +41,71 @@ struct Resource {
   QString source = "";
   QString value = "";
   qint64 timestamp = 0;
+  // Where the value is stored in 'db.bin' or 'db.xml' if it hasn't been read yet,
+  // otherwise -1
+  qint64 valueOffset = -1;
 };
 
+// The resources of a single rom by type. Each type has a resource per source
+typedef QMap<QString, QList<Resource> > RomResources;
+
+class BinaryDb;
+class XmlIndex;
+
 class LocalDb : public QObject
 {
   Q_OBJECT
 
 public:
-  LocalDb(const QString &dbFolder);
+  LocalDb(const QString &dbFolder, const QString &dbFormat = "xml");
+  ~LocalDb();
   bool createFolders(const QString &scraper);
   bool readDb();
   void readPriorities();
   bool writeDb();
+  bool exportDb();
   void cleanDb();
-  void addResources(GameEntry &entry, const bool &update);
+  QList<Resource> addResources(GameEntry &entry, const bool &update);
+  void restoreResources(const QList<Resource> &restored);
   void fillBlanks(GameEntry &entry);
   void printResources();
   bool hasSha1(const QString &sha1);
+  int rekeyResources(const QString &oldSha1, const QString &newSha1);
+  QList<Resource> copyResources(const QString &fromSha1, const QString &toSha1,
+				const QString &source, const bool &update);
   void mergeDb(LocalDb &srcDb, bool overwrite, const QString &srcDbFolder);
   QList<Resource> getResources();
 
  private:
   QDir dbDir;
-  QMutex dbMutex;
+  BinaryDb *binaryDb;
+  XmlIndex *xmlIndex;
+  // Lookups share the lock, changes to the resources take it alone. Media files are
+  // read and written outside of it
+  QReadWriteLock dbLock;
 
   QMap<QString, QList<QString> > prioMap;
   
-  QList<Resource> resources;
-  void addResource(const Resource &resource, GameEntry &entry, const QString &dbAbsolutePath, const bool &update);
+  // Indexed by sha1, so a rom's resources are found without going through them all.
+  // A rom or type without resources is removed, it's never left empty
+  QHash<QString, RomResources> resources;
+  bool readXml();
+  bool readXmlIndex();
+  void writeXmlIndex();
+  bool writeXml();
+  bool readBinaryDb();
+  bool compactDb();
+  QString getValue(const Resource &resource);
+  static bool isLazyType(const QString &type);
+  bool isMediaMissing(const Resource &resource);
+  int resourceCount();
+  bool hasResource(const Resource &resource);
+  void insertResource(const Resource &resource);
+  void removeResource(const Resource &resource);
+  bool addResource(const Resource &resource, GameEntry &entry, const QString &dbAbsolutePath, const bool &update);
+  static bool saveMedia(const Resource &resource, GameEntry &entry, const QString &dbAbsolutePath);
   void verifyResources(QDirIterator &dirIt, int &deleted, int &noDelete, QString resType);
-  bool fillType(QString &type, QList<Resource> &sha1Resources, QString &result);
+  bool fillType(QString &type, const RomResources &romResources, QString &result);
   
 };
 
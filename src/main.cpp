@@ -37,6 +37,7 @@
 #include "skyscraper.h"
 #include "scripter.h"
 #include "platform.h"
+#include "hashstage.h"
 
 void customMessageHandler(QtMsgType type, const QMessageLogContext&, const QString &msg)
 {
@@ -101,7 +102,7 @@ int main(int argc, char *argv[])
 
   parser.setApplicationDescription("\033[1;34m----------------------------------\033[0m\n\033[1;33mSkyscraper v" VERSION " by Lars Muldjord\033[0m\n\033[1;34m----------------------------------\033[0m\nThis scraper looks for compatible game files in the input directory. It fetches boxart, screenshots and other relevant information for the games based on their filenames, then builds a gamelist file for use with the chosen frontend.");
   parser.addHelpOption();
-  QCommandLineOption pOption("p", "The platform you wish to scrape.\n(Currently supports " + platforms + ".)", "platform", "");
+  QCommandLineOption pOption("p", "The platform you wish to scrape. Several platforms can be scraped in one go by separating them with commas, or by setting it to 'all'.\n(Currently supports " + platforms + ".)", "platform", "");
   QCommandLineOption fOption("f", "Frontend to scrape for.\n(Currently supports 'emulationstation' and 'attractmode'. Default is 'emulationstation')", "frontend", "");
   QCommandLineOption eOption("e", "Set emulator. This is only required by the 'attractmode' frontend.\n(Default is none)", "emulator", "");
   QCommandLineOption iOption("i", "Folder which contains the game files.\n(default is '/home/pi/RetroPie/roms/[platform]')", "path", "");
@@ -112,7 +113,8 @@ int main(int argc, char *argv[])
   QCommandLineOption uOption("u", "UserID and Password for use with the selected scraper module.\n(Default is none)", "user:password", "");
   QCommandLineOption mOption("m", "Minimum match percentage when comparing search result titles to filename titles.\n(default is 50)", "0-100", "");
   QCommandLineOption lOption("l", "Maximum game description length. Everything longer than this will be truncated.\n(default is 10000)", "0-10000", "");
-  QCommandLineOption tOption("t", "Number of scraper threads to use.\n(default is 4)", "1-8", "");
+  QCommandLineOption tOption("t", "Number of scraper threads to use. Set to 'auto' to let Skyscraper adjust the number of threads while scraping. Set to 'async' to scrape many files at once from a single network thread, as many as '--inflight' allows (only 'screenscraper' supports this, other modules use threads).\n(default is 4)", "1-64|auto|async", "");
+  QCommandLineOption inflightOption("inflight", "Maximum number of network requests in flight at the same time, shared by all scraper threads. A scraper thread still waits for its own requests, so it takes several threads to fill this, unless '-t async' is used.\n(default is 16)", "1-256", "");
   QCommandLineOption cOption("c", "Use this config file to set up the scraper.\n(default is '[homedir]/.skyscraper/config.ini')", "filename", "");
   QCommandLineOption dOption("d", "Set local resource database folder.\n(default is '[homedir]/.skyscraper/dbs/[platform]')", "folder", "");
   QCommandLineOption videosOption("videos", "Enables video scraping for any scraping module. Also enables caching of video resources in the local databases. Beware, this takes up a lot of disk space!");
@@ -121,13 +123,19 @@ int main(int argc, char *argv[])
   QCommandLineOption nolocaldbOption("nolocaldb", "Disables local db resources. Other local db flags will then be ignored.");
   QCommandLineOption updatedbOption("updatedb", "Refresh all existing resources in local db using selected scraper. Set specific db folder with '-d'. Otherwise default db folder is used.");
   QCommandLineOption cleandbOption("cleandb", "Remove media files that have no entry in the db. Set specific db folder with '-d'. Otherwise default db folder is used.");
+  QCommandLineOption exportdbOption("exportdb", "Write the local db to 'db.xml' in the db folder. Use it to get a copy readable by other tools when 'dbFormat' is set to 'binary' in the config. Set specific db folder with '-d'. Otherwise default db folder is used.");
   QCommandLineOption mergedbOption("mergedb", "Merge data from a specific db folder into local destination db. Set db you wish to merge from with this flag. Set destination db folder with '-d'. Otherwise default destination db folder is used.", "folder", "");
   QCommandLineOption nosubdirsOption("nosubdirs", "Do not include input folder subdirectories when scraping.");
   QCommandLineOption pretendOption("pretend", "Don't alter any files (except 'skipped.txt'), just print the results on screen.");
+  QCommandLineOption resumeOption("resume", "Continue a scraping run that was interrupted. Games that were already done are read back from the run journal and won't be scraped again.");
+  QCommandLineOption incrementalOption("incremental", "Only scrape files that are new or have changed since the last completed run. Renamed files keep their result and the games of removed files are dropped from the gamelist.");
+  QCommandLineOption watchOption("watch", "Keep running after scraping and watch the input folder. New or changed files are scraped and the gamelist is updated as they appear.");
+  QCommandLineOption rehashOption("rehash", "Ignore the cached rom checksums in the local db folder and calculate them all again.");
   QCommandLineOption unattendOption("unattend", "Don't ask any questions when scraping. It will then always overwrite existing gamelist and not skip existing entries.");
   QCommandLineOption regionOption("region", "Set preferred game region for scraping modules that support it.\n(Default 'wor')", "code", "wor");
   QCommandLineOption langOption("lang", "Set preferred result language for scraping modules that support it.\n(Default 'en')", "code", "en");
   QCommandLineOption verboseOption("verbose", "Print more info while scraping.");
+  QCommandLineOption hashbenchOption("hashbench", "Measure the speed of each checksum kernel supported by the cpu, and how fast the rom files in a folder (or a single file) are read and hashed compared to the old 1 KB reads, and exit.", "path", "");
   
   parser.addOption(pOption);
   parser.addOption(iOption);
@@ -141,6 +149,7 @@ int main(int argc, char *argv[])
   parser.addOption(mOption);
   parser.addOption(lOption);
   parser.addOption(tOption);
+  parser.addOption(inflightOption);
   parser.addOption(cOption);
   parser.addOption(dOption);
   parser.addOption(videosOption);
@@ -151,18 +160,27 @@ int main(int argc, char *argv[])
   //parser.addOption(checkdbOption);
   parser.addOption(cleandbOption);
   parser.addOption(mergedbOption);
+  parser.addOption(exportdbOption);
   parser.addOption(nosubdirsOption);
   parser.addOption(pretendOption);
   parser.addOption(unattendOption);
+  parser.addOption(resumeOption);
+  parser.addOption(incrementalOption);
+  parser.addOption(watchOption);
+  parser.addOption(rehashOption);
   parser.addOption(langOption);
   parser.addOption(regionOption);
   parser.addOption(verboseOption);
+  parser.addOption(hashbenchOption);
 
   parser.process(app);
 
   if(argc > 1) {
     if(parser.isSet("help") || parser.isSet("h")) {
       parser.showHelp();
+    } else if(parser.isSet("hashbench")) {
+      HashStage::runBenchmark(parser.value("hashbench"));
+      return 0;
     } else {
       Skyscraper *x = new Skyscraper(parser);
       QObject::connect(x, &Skyscraper::finished, &app, &QCoreApplication::quit);
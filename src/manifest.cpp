@@ -0,0 +1,118 @@
+/***************************************************************************
+ *            manifest.cpp
+ *
+ *  Fri Jan 19 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QJsonDocument>
+
+#include "manifest.h"
+
+Manifest::Manifest(const QString &fileName)
+{
+  readFile.setFileName(fileName);
+  writeFile.setFileName(fileName);
+}
+
+bool Manifest::exists()
+{
+  return readFile.exists();
+}
+
+// Starts reading the records from the beginning. They are read one at a time, so
+// big collections don't have to fit in memory
+bool Manifest::rewind()
+{
+  if(readFile.isOpen()) {
+    return readFile.seek(0);
+  }
+  return readFile.open(QIODevice::ReadOnly);
+}
+
+bool Manifest::nextRecord(ManifestRecord &record)
+{
+  while(readFile.isOpen() && !readFile.atEnd()) {
+    QJsonDocument json = QJsonDocument::fromJson(readFile.readLine());
+    if(!json.isObject()) {
+      continue;
+    }
+    record.state = json.object().value("state").toString();
+    record.entry = GameEntry();
+    record.entry.fromJson(json.object().value("entry").toObject());
+    return true;
+  }
+  readFile.close();
+  return false;
+}
+
+// The new manifest only replaces the old one once it has been completely written
+bool Manifest::open()
+{
+  return writeFile.open(QIODevice::WriteOnly);
+}
+
+void Manifest::addRecord(const QString &state, const GameEntry &entry)
+{
+  QJsonObject record;
+  record.insert("state", state);
+  record.insert("entry", entry.toJson());
+  writeFile.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+}
+
+bool Manifest::commit()
+{
+  return writeFile.commit();
+}
+
+// Zips are keyed by their name in the local db, so a renamed zip is only found by
+// the checksum of the rom inside. That is only known if the scraper needs it
+void Manifest::addMissing(const GameEntry &entry)
+{
+  QMutexLocker locker(&missingMutex);
+  missing.insert(entry.romSha1.isEmpty()?entry.sha1:"rom:" + entry.romSha1, entry);
+}
+
+// Returns the entry of a file that is gone, if a new file has the same rom checksum
+// or the same local db key
+bool Manifest::takeMoved(const QString &sha1, const QString &romSha1, GameEntry &entry)
+{
+  QMutexLocker locker(&missingMutex);
+  QMultiHash<QString, GameEntry>::iterator it = missing.end();
+  if(!romSha1.isEmpty()) {
+    it = missing.find("rom:" + romSha1);
+  }
+  if(it == missing.end()) {
+    it = missing.find(sha1);
+  }
+  if(it == missing.end()) {
+    return false;
+  }
+  entry = it.value();
+  missing.erase(it);
+  return true;
+}
+
+int Manifest::missingCount()
+{
+  QMutexLocker locker(&missingMutex);
+  return missing.count();
+}
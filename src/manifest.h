@@ -0,0 +1,68 @@
+/***************************************************************************
+ *            manifest.h
+ *
+ *  Fri Jan 19 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <QFile>
+#include <QSaveFile>
+#include <QMultiHash>
+#include <QMutex>
+
+#include "gameentry.h"
+
+struct ManifestRecord {
+  QString state = "";
+  GameEntry entry;
+};
+
+// The files of the last completed run, with their size and modification time,
+// their local db key and their gamelist entry. '--incremental' compares the input
+// files against it, so only new or changed files are scraped. Entries of files
+// that are gone are kept aside until the new files have been hashed, since some
+// of them may just have been renamed.
+class Manifest
+{
+public:
+  Manifest(const QString &fileName);
+  bool exists();
+  bool rewind();
+  bool nextRecord(ManifestRecord &record);
+  bool open();
+  void addRecord(const QString &state, const GameEntry &entry);
+  bool commit();
+  void addMissing(const GameEntry &entry);
+  bool takeMoved(const QString &sha1, const QString &romSha1, GameEntry &entry);
+  int missingCount();
+
+private:
+  QFile readFile;
+  QSaveFile writeFile;
+  QMultiHash<QString, GameEntry> missing;
+  QMutex missingMutex;
+
+};
+
+#endif // MANIFEST_H
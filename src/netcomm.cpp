@@ -24,41 +24,109 @@
  */
 
 #include "netcomm.h"
+#include "hostgovernor.h"
 
 #include <QUrl>
 #include <QNetworkRequest>
+#include <QEventLoop>
 
 NetComm::NetComm()
 {
   connect(this, &NetComm::finished, this, &NetComm::replyFinished);
   data = "";
-  requestTimer.setSingleShot(true);
-  requestTimer.setInterval(30000);
-  connect(&requestTimer, &QTimer::timeout, this, &NetComm::requestTimout);
+  retryTimer.setSingleShot(true);
+  connect(&retryTimer, &QTimer::timeout, this, &NetComm::startPending);
 }
 
 NetComm::~NetComm()
 {
 }
 
+// Blocking style request. Emits 'dataReady' when done, after which the result can be
+// read with getData(), getRedirUrl() and getContentType()
 void NetComm::request(QString query, QString postData)
 {
-  QUrl url(query);
+  NetReply *netReply = requestAsync(query, postData);
+  connect(netReply, &NetReply::finished, this, &NetComm::requestFinished);
+}
+
+// Returns a handle right away. Requests that HostGovernor is holding back, because
+// of the limits of their host or the limit on requests in flight in total, are
+// queued and started later
+NetReply *NetComm::requestAsync(QString query, QString postData)
+{
+  NetReply *netReply = new NetReply(query, postData, this);
+  pending.append(netReply);
+  startPending();
+  return netReply;
+}
+
+void NetComm::startPending()
+{
+  int wait = 0;
+  for(int a = 0; a < pending.length(); ++a) {
+    // With nothing of our own in flight we can safely wait for other threads to
+    // release a request. Otherwise we try again when one of ours is done
+    int hostWait = HostGovernor::acquire(QUrl(pending.at(a)->getQuery()).host(),
+					 active.isEmpty());
+    if(hostWait == 0) {
+      startRequest(pending.takeAt(a));
+      a--;
+    } else if(hostWait > 0 && (wait == 0 || hostWait < wait)) {
+      wait = hostWait;
+    }
+  }
+  if(wait > 0 && (!retryTimer.isActive() || wait < retryTimer.remainingTime())) {
+    retryTimer.start(wait);
+  }
+}
+
+void NetComm::startRequest(NetReply *netReply)
+{
+  QUrl url(netReply->getQuery());
   QNetworkRequest request(url);
   request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/57.0.2987.133 Safari/537.36");
 
-  if(postData.isEmpty()) {
-    get(request);
+  QNetworkReply *reply;
+  if(netReply->getPostData().isEmpty()) {
+    reply = get(request);
   } else {
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-    post(request, postData.toUtf8());
+    reply = post(request, netReply->getPostData().toUtf8());
+  }
+  active.insert(reply, netReply);
+  netReply->setNetworkReply(reply);
+}
+
+void NetComm::waitForReplies(const QList<NetReply *> &replies)
+{
+  QEventLoop loop;
+  foreach(NetReply *netReply, replies) {
+    connect(netReply, &NetReply::finished, &loop, &QEventLoop::quit);
+  }
+  while(true) {
+    bool allFinished = true;
+    foreach(NetReply *netReply, replies) {
+      if(!netReply->isFinished()) {
+	allFinished = false;
+	break;
+      }
+    }
+    if(allFinished) {
+      break;
+    }
+    loop.exec();
   }
-  requestTimer.start();
 }
 
 void NetComm::replyFinished(QNetworkReply *reply)
 {
-  requestTimer.stop();
+  NetReply *netReply = active.take(reply);
+  reply->deleteLater();
+  if(netReply == nullptr) {
+    return;
+  }
+  QString host = QUrl(netReply->getQuery()).host();
   /*
   QUrl url = reply->url();
   if(reply->error()) {
@@ -71,16 +139,43 @@ void NetComm::replyFinished(QNetworkReply *reply)
     printf("RAW HEADER: '%s', '%s'\n", header.first.data(), header.second.data());
   }
   */
-  // If we got redirected, we need to know where to proceed from
-  contentType = reply->rawHeader("Content-Type");
-
-  if(reply->rawHeader("Location").left(4) == "http") {
-    redirUrl = reply->rawHeader("Location");
+  int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if((statusCode == 429 || statusCode == 503) && netReply->getRetries() < 3) {
+    // Server wants us to slow down. Hold back all threads and try again later
+    HostGovernor::backOff(host, reply->rawHeader("Retry-After"));
+    HostGovernor::release(host);
+    netReply->prepareRetry();
+    pending.prepend(netReply);
+    startPending();
+    return;
+  }
+  HostGovernor::release(host);
+  if(reply->error() == QNetworkReply::OperationCanceledError) {
+    // Request timed out
+    netReply->setResult("", "", "", 0);
   } else {
-    redirUrl = "";
+    // If we got redirected, we need to know where to proceed from
+    QByteArray redirUrl = "";
+    if(reply->rawHeader("Location").left(4) == "http") {
+      redirUrl = reply->rawHeader("Location");
+    }
+    netReply->setResult(reply->readAll(), redirUrl, reply->rawHeader("Content-Type"),
+			statusCode);
   }
-  data = reply->readAll();
-  reply->deleteLater();
+
+  startPending();
+}
+
+void NetComm::requestFinished()
+{
+  NetReply *netReply = qobject_cast<NetReply *>(sender());
+  if(netReply == nullptr) {
+    return;
+  }
+  data = netReply->getData();
+  redirUrl = netReply->getRedirUrl();
+  contentType = netReply->getContentType();
+  netReply->deleteLater();
   emit dataReady();
 }
 
@@ -98,11 +193,3 @@ QByteArray NetComm::getContentType()
 {
   return contentType;
 }
-
-void NetComm::requestTimout()
-{
-  data = "";
-  redirUrl = "";
-  contentType = "";
-  emit dataReady();
-}
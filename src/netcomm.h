@@ -29,6 +29,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QMap>
+
+#include "netreply.h"
 
 class NetComm : public QNetworkAccessManager
 {
@@ -38,20 +41,26 @@ public:
   NetComm();
   ~NetComm();
   void request(QString query, QString postData = "");
+  NetReply *requestAsync(QString query, QString postData = "");
+  void waitForReplies(const QList<NetReply *> &replies);
   QByteArray getData();
   QByteArray getRedirUrl();
   QByteArray getContentType();
 
 private slots:
   void replyFinished(QNetworkReply *reply);
-  void requestTimout();
-
+  void requestFinished();
+  void startPending();
 
 signals:
   void dataReady();
   
 private:
-  QTimer requestTimer;
+  void startRequest(NetReply *netReply);
+
+  QList<NetReply *> pending;
+  QMap<QNetworkReply *, NetReply *> active;
+  QTimer retryTimer;
   QByteArray redirUrl;
   QByteArray contentType;
   QByteArray data;
@@ -0,0 +1,126 @@
+/***************************************************************************
+ *            netreply.cpp
+ *
+ *  Fri Jan 5 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QNetworkReply>
+
+#include "netreply.h"
+
+NetReply::NetReply(const QString &query, const QString &postData, QObject *parent)
+  : QObject(parent)
+{
+  this->query = query;
+  this->postData = postData;
+  networkReply = nullptr;
+  statusCode = 0;
+  retries = 0;
+  done = false;
+  requestTimer.setSingleShot(true);
+  requestTimer.setInterval(30000);
+  connect(&requestTimer, &QTimer::timeout, this, &NetReply::requestTimeout);
+}
+
+NetReply::~NetReply()
+{
+}
+
+bool NetReply::isFinished()
+{
+  return done;
+}
+
+QString NetReply::getQuery()
+{
+  return query;
+}
+
+QString NetReply::getPostData()
+{
+  return postData;
+}
+
+QByteArray NetReply::getData()
+{
+  return data;
+}
+
+QByteArray NetReply::getRedirUrl()
+{
+  return redirUrl;
+}
+
+QByteArray NetReply::getContentType()
+{
+  return contentType;
+}
+
+int NetReply::getStatusCode()
+{
+  return statusCode;
+}
+
+int NetReply::getRetries()
+{
+  return retries;
+}
+
+// Called when the server asked us to back off. The request is then queued again
+void NetReply::prepareRetry()
+{
+  requestTimer.stop();
+  networkReply = nullptr;
+  retries++;
+}
+
+void NetReply::setNetworkReply(QNetworkReply *networkReply)
+{
+  this->networkReply = networkReply;
+  requestTimer.start();
+}
+
+QNetworkReply *NetReply::getNetworkReply()
+{
+  return networkReply;
+}
+
+void NetReply::setResult(const QByteArray &data, const QByteArray &redirUrl,
+			 const QByteArray &contentType, const int &statusCode)
+{
+  requestTimer.stop();
+  networkReply = nullptr;
+  this->data = data;
+  this->redirUrl = redirUrl;
+  this->contentType = contentType;
+  this->statusCode = statusCode;
+  done = true;
+  emit finished();
+}
+
+// Aborting makes the network manager finish the reply with no data
+void NetReply::requestTimeout()
+{
+  if(networkReply != nullptr) {
+    networkReply->abort();
+  }
+}
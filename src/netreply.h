@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            netreply.h
+ *
+ *  Fri Jan 5 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef NETREPLY_H
+#define NETREPLY_H
+
+#include <QObject>
+#include <QTimer>
+
+class QNetworkReply;
+
+// Handle for a single request made through NetComm::requestAsync. Emits
+// 'finished' once the data is available or the request has timed out.
+class NetReply : public QObject
+{
+  Q_OBJECT
+
+public:
+  NetReply(const QString &query, const QString &postData, QObject *parent);
+  ~NetReply();
+  bool isFinished();
+  QString getQuery();
+  QString getPostData();
+  QByteArray getData();
+  QByteArray getRedirUrl();
+  QByteArray getContentType();
+  int getStatusCode();
+  int getRetries();
+  void prepareRetry();
+
+  void setNetworkReply(QNetworkReply *networkReply);
+  QNetworkReply *getNetworkReply();
+  void setResult(const QByteArray &data, const QByteArray &redirUrl,
+		 const QByteArray &contentType, const int &statusCode);
+
+signals:
+  void finished();
+
+private slots:
+  void requestTimeout();
+
+private:
+  QNetworkReply *networkReply;
+  QTimer requestTimer;
+  QString query;
+  QString postData;
+  QByteArray data;
+  QByteArray redirUrl;
+  QByteArray contentType;
+  int statusCode;
+  int retries;
+  bool done;
+
+};
+
+#endif // NETREPLY_H
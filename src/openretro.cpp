@@ -102,7 +102,7 @@ void OpenRetro::getSearchResults(QList<GameEntry> &gameEntries,
   }
 }
 
-void OpenRetro::getScreenshot(GameEntry &game)
+void OpenRetro::getScreenshot(GameEntry &)
 {
   // Check that we have enough screenshots
   int screens = data.count(screenshotCounter.toUtf8());
@@ -117,27 +117,17 @@ void OpenRetro::getScreenshot(GameEntry &game)
     }
   }
   QString screenshotUrl = baseUrl + data.left(data.indexOf(screenshotPost)) + "?s=1x";
-  manager.request(screenshotUrl);
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.screenshotData = image;
-  }
+  addToFetchPlan(SCREENSHOT, screenshotUrl);
 }
 
-void OpenRetro::getCover(GameEntry &game)
+void OpenRetro::getCover(GameEntry &)
 {
   nomNom("</div></div><a href=\"");
   QString coverUrl = baseUrl + data.left(data.indexOf("?s=")) + "?s=1x";
   if(coverUrl.indexOf("0000000000") != -1) {
     return;
   }
-  manager.request(coverUrl);
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.coverData = image;
-  }
+  addToFetchPlan(COVER, coverUrl);
 }
 
 void OpenRetro::getTags(GameEntry &game)
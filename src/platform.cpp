@@ -524,6 +524,43 @@ QStringList Platform::getAliases(QString platform)
   return aliases;
 }
 
+// Tells how a rom dump differs from the form the rom databases have checksums for.
+// 'start' is the beginning of the rom and 'size' its full size. 'headerSize' is
+// set to the number of bytes to skip, 'wordSwap' to 2 or 4 if the byte order of
+// every 16 or 32 bit word must be reversed
+void Platform::getRomLayout(QString platform, const QByteArray &start, qint64 size,
+			    int &headerSize, int &wordSwap)
+{
+  headerSize = 0;
+  wordSwap = 0;
+  if(platform == "nes") {
+    // iNES and NES 2.0 header
+    if(start.startsWith("NES\x1a")) {
+      headerSize = 16;
+    }
+  } else if(platform == "snes") {
+    // Copier header. Only there if the size is 512 bytes off a whole kilobyte
+    if(size % 1024 == 512) {
+      headerSize = 512;
+    }
+  } else if(platform == "atarilynx") {
+    if(start.startsWith(QByteArray("LYNX\0", 5))) {
+      headerSize = 64;
+    }
+  } else if(platform == "atari7800") {
+    if(start.mid(1, 9) == "ATARI7800") {
+      headerSize = 128;
+    }
+  } else if(platform == "n64") {
+    // Databases use the big endian byte order of .z64 files
+    if(start.startsWith("\x37\x80\x40\x12")) {
+      wordSwap = 2; // .v64
+    } else if(start.startsWith("\x40\x12\x37\x80")) {
+      wordSwap = 4; // .n64
+    }
+  }
+}
+
 // --- Console colors ---
 // Black        0;30     Dark Gray     1;30
 // Red          0;31     Light Red     1;31
@@ -42,6 +42,8 @@ public:
   static QString getFormats(QString platform);
   static QString getDefaultScraper(QString platform);
   static QStringList getAliases(QString platform);
+  static void getRomLayout(QString platform, const QByteArray &start, qint64 size,
+			   int &headerSize, int &wordSwap);
 
 private:
   
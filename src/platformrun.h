@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            platformrun.h
+ *
+ *  Sun Jan 21 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef PLATFORMRUN_H
+#define PLATFORMRUN_H
+
+#include <QMap>
+#include <QSharedPointer>
+
+#include "settings.h"
+#include "abstractfrontend.h"
+#include "localdb.h"
+#include "hashcache.h"
+#include "journal.h"
+#include "manifest.h"
+#include "dupetracker.h"
+#include "entryspool.h"
+
+// Everything that belongs to one platform of a scraping run. In batch mode the
+// files of all platforms are hashed, scraped and written by the same threads,
+// and each job carries the platform it belongs to.
+struct PlatformRun {
+  int index = 0;
+  Settings config;
+  bool romDigests = false; // Set if the scraper searches by rom checksums
+  QSharedPointer<AbstractFrontend> frontend;
+  QSharedPointer<LocalDb> localDb;
+  QSharedPointer<HashCache> hashCache;
+  QSharedPointer<Journal> journal;
+  QSharedPointer<Manifest> manifest;
+  QSharedPointer<DupeTracker> dupes;
+  EntrySpool gameEntries;
+  QMap<QString, QString> knownFiles;
+  QMap<QString, GameEntry> skippedEntries;
+  QString gameListFileString = "";
+  QString skippedFileString = "";
+  QString journalFileString = "";
+  QString manifestFileString = "";
+  int totalFiles = 0;
+  int notFound = 0;
+  int found = 0;
+  int avgSearchMatch = 0;
+  int avgCompleteness = 0;
+  int scraped = 0; // Files scraped in this session, resumed ones not included
+  bool abandoned = false; // Set if the scraper doesn't seem to support the platform
+};
+
+#endif // PLATFORMRUN_H
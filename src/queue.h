@@ -0,0 +1,49 @@
+/***************************************************************************
+ *            queue.h
+ *
+ *  Tue Jan 2 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <QList>
+#include <QMutex>
+
+#include "scrapequeue.h"
+
+// Shared job queue that all scraper threads pull their files from. Threads take
+// one file at a time, so a thread that gets stuck on a slow game doesn't hold
+// back any of the other files.
+class Queue : public QList<ScrapeJob>
+{
+public:
+  Queue();
+  bool takeEntry(ScrapeJob &job);
+  bool takeEntry(ScrapeJob &job, ScrapeJob &next);
+
+private:
+  QMutex queueMutex;
+
+};
+
+#endif // QUEUE_H
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *            romreader.cpp
+ *
+ *  Sat Jan 13 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include "romreader.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+// Size of each read. Big enough to keep the syscall count low on slow storage
+#define BLOCKSIZE 1048576
+// How much of a file is requested from the kernel before it is read
+#define PREFETCHSIZE 8388608
+
+RomReader::RomReader()
+{
+  buffer.resize(BLOCKSIZE);
+}
+
+bool RomReader::open(const QString &path)
+{
+  romFile.setFileName(path);
+  // Unbuffered, since QFile would otherwise copy everything through its own buffer
+  if(!romFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    return false;
+  }
+#ifdef Q_OS_LINUX
+  posix_fadvise(romFile.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise(romFile.handle(), 0, PREFETCHSIZE, POSIX_FADV_WILLNEED);
+#endif
+  return true;
+}
+
+// Returns the number of bytes read into 'data', 0 at end of file and -1 on errors
+qint64 RomReader::readBlock(const char *&data)
+{
+  char *block = buffer.data();
+  qint64 length = 0;
+  // Network filesystems may return less than asked for, so keep going until full
+  while(length < BLOCKSIZE) {
+    qint64 bytesRead = romFile.read(block + length, BLOCKSIZE - length);
+    if(bytesRead == -1) {
+      return -1;
+    }
+    if(bytesRead == 0) {
+      break;
+    }
+    length += bytesRead;
+  }
+  data = block;
+  return length;
+}
+
+void RomReader::close()
+{
+  romFile.close();
+}
+
+// Asks the kernel to start reading the beginning of a file in the background. Used
+// on the next file in the queue so it is already cached once the hasher gets to it
+void RomReader::prefetch(const QString &path)
+{
+#ifdef Q_OS_LINUX
+  QFile nextFile(path);
+  if(nextFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    posix_fadvise(nextFile.handle(), 0, PREFETCHSIZE, POSIX_FADV_WILLNEED);
+    nextFile.close();
+  }
+#else
+  Q_UNUSED(path);
+#endif
+}
+
+// Drops a file from the page cache so it will be read from disk next time
+void RomReader::dropCache(const QString &path)
+{
+#ifdef Q_OS_LINUX
+  QFile cachedFile(path);
+  if(cachedFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    posix_fadvise(cachedFile.handle(), 0, 0, POSIX_FADV_DONTNEED);
+    cachedFile.close();
+  }
+#else
+  Q_UNUSED(path);
+#endif
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+ *            romreader.h
+ *
+ *  Sat Jan 13 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef ROMREADER_H
+#define ROMREADER_H
+
+#include <QFile>
+#include <QByteArray>
+
+// Reads rom files in large blocks into a buffer that is reused from file to file.
+// The kernel is told that the file is read sequentially, so it can read ahead
+// while the previous block is being hashed.
+class RomReader
+{
+public:
+  RomReader();
+  bool open(const QString &path);
+  qint64 readBlock(const char *&data);
+  void close();
+  static void prefetch(const QString &path);
+  static void dropCache(const QString &path);
+
+private:
+  QFile romFile;
+  QByteArray buffer;
+
+};
+
+#endif // ROMREADER_H
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *            scrapequeue.cpp
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <climits>
+#include <QElapsedTimer>
+
+#include "scrapequeue.h"
+
+ScrapeQueue::ScrapeQueue(int capacity)
+{
+  this->capacity = (capacity < 1?1:capacity);
+  activeWorkers = INT_MAX;
+  waitMsecs = 0;
+  closed = false;
+}
+
+void ScrapeQueue::addJob(const ScrapeJob &job)
+{
+  QMutexLocker locker(&queueMutex);
+
+  while(jobs.length() >= capacity) {
+    notFull.wait(&queueMutex);
+  }
+  if(abandonedRuns.contains(job.run.data())) {
+    return;
+  }
+  jobs.append(job);
+  // Only active workers wait on this, so any one of them can take the job
+  notEmpty.wakeOne();
+}
+
+// Workers numbered at or above the active worker count are parked here until
+// they are needed again, or until the queue is closed
+bool ScrapeQueue::takeJob(ScrapeJob &job, int worker)
+{
+  QMutexLocker locker(&queueMutex);
+
+  while(jobs.isEmpty() || worker >= activeWorkers) {
+    if(closed) {
+      return false;
+    }
+    if(worker < activeWorkers) {
+      // An active worker with nothing to do means hashing isn't keeping up
+      QElapsedTimer waitTimer;
+      waitTimer.start();
+      notEmpty.wait(&queueMutex);
+      waitMsecs += waitTimer.elapsed();
+    } else {
+      notParked.wait(&queueMutex);
+    }
+  }
+  job = jobs.takeFirst();
+  notFull.wakeOne();
+  return true;
+}
+
+// Never waits. Returns false if there is no job at the moment
+bool ScrapeQueue::tryTakeJob(ScrapeJob &job)
+{
+  QMutexLocker locker(&queueMutex);
+
+  if(jobs.isEmpty()) {
+    return false;
+  }
+  job = jobs.takeFirst();
+  notFull.wakeOne();
+  return true;
+}
+
+// Called when no more jobs will be added. Wakes up any thread waiting for a job
+void ScrapeQueue::close()
+{
+  QMutexLocker locker(&queueMutex);
+
+  closed = true;
+  notEmpty.wakeAll();
+  notParked.wakeAll();
+}
+
+// Drops the queued jobs of a platform that is given up on, and any added later
+void ScrapeQueue::abandonRun(const PlatformRun *platformRun)
+{
+  QMutexLocker locker(&queueMutex);
+
+  abandonedRuns.insert(platformRun);
+  for(int a = jobs.length() - 1; a >= 0; --a) {
+    if(jobs.at(a).run.data() == platformRun) {
+      jobs.removeAt(a);
+    }
+  }
+  notFull.wakeAll();
+}
+
+bool ScrapeQueue::isAbandoned(const PlatformRun *platformRun)
+{
+  QMutexLocker locker(&queueMutex);
+
+  return abandonedRuns.contains(platformRun);
+}
+
+void ScrapeQueue::setActiveWorkers(int activeWorkers)
+{
+  QMutexLocker locker(&queueMutex);
+
+  this->activeWorkers = (activeWorkers < 1?1:activeWorkers);
+  // Newly parked workers move over to wait for being unparked and vice versa
+  notEmpty.wakeAll();
+  notParked.wakeAll();
+}
+
+int ScrapeQueue::getActiveWorkers()
+{
+  QMutexLocker locker(&queueMutex);
+
+  return activeWorkers;
+}
+
+// Returns the time active workers have spent waiting for jobs since last call
+qint64 ScrapeQueue::takeWaitMsecs()
+{
+  QMutexLocker locker(&queueMutex);
+
+  qint64 msecs = waitMsecs;
+  waitMsecs = 0;
+  return msecs;
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            scrapequeue.h
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef SCRAPEQUEUE_H
+#define SCRAPEQUEUE_H
+
+#include <QList>
+#include <QFileInfo>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QSet>
+
+struct PlatformRun;
+
+struct ScrapeJob {
+  QFileInfo info;
+  QSharedPointer<PlatformRun> run; // Platform the file belongs to
+  QString sha1 = ""; // Key used by the local db
+  // Digests of the actual rom data, only calculated if the scraper needs them
+  QString romSha1 = "";
+  QString romMd5 = "";
+  QString romCrc32 = "";
+};
+
+// Bounded queue between the hashing stage and the scraper threads. Adding blocks
+// while the queue is full, so hashing never runs too far ahead of the network.
+class ScrapeQueue
+{
+public:
+  ScrapeQueue(int capacity);
+  void addJob(const ScrapeJob &job);
+  bool takeJob(ScrapeJob &job, int worker = 0);
+  bool tryTakeJob(ScrapeJob &job);
+  void close();
+  void abandonRun(const PlatformRun *platformRun);
+  bool isAbandoned(const PlatformRun *platformRun);
+  void setActiveWorkers(int activeWorkers);
+  int getActiveWorkers();
+  qint64 takeWaitMsecs();
+
+private:
+  QList<ScrapeJob> jobs;
+  QSet<const PlatformRun *> abandonedRuns;
+  QMutex queueMutex;
+  QWaitCondition notFull;
+  QWaitCondition notEmpty;
+  QWaitCondition notParked;
+  int capacity;
+  int activeWorkers;
+  qint64 waitMsecs;
+  bool closed;
+
+};
+
+#endif // SCRAPEQUEUE_H
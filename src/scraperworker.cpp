@@ -28,7 +28,7 @@
 #include "scraperworker.h"
 #include "strtools.h"
 #include "settings.h"
-#include "compositor.h"
+#include "hostgovernor.h"
 
 #include "openretro.h"
 #include "thegamesdb.h"
@@ -38,192 +38,332 @@
 #include "importscraper.h"
 #include "arcadedb.h"
 
-ScraperWorker::ScraperWorker(QList<QFileInfo> inputFiles, int filesPerThread, int beginIdx,
-			     Settings config, QSharedPointer<LocalDb> localDb)
+ScraperWorker::ScraperWorker(QSharedPointer<ScrapeQueue> scrapeQueue,
+			     QSharedPointer<WriteStage> writeStage, int worker)
 {
-  this->config = config;
-  this->localDb = localDb;
-  this->inputFiles = inputFiles;
-  this->filesPerThread = filesPerThread;
-  this->beginIdx = beginIdx;
+  this->worker = worker;
+  this->scrapeQueue = scrapeQueue;
+  this->writeStage = writeStage;
 }
 
 ScraperWorker::~ScraperWorker()
 {
 }
 
-void ScraperWorker::run()
+AbstractScraper *ScraperWorker::createScraper(const QString &scraper)
 {
-  AbstractScraper *scraper;
-
-  if(config.scraper == "openretro") {
-    scraper = new OpenRetro();
-  } else if(config.scraper == "thegamesdb") {
-    scraper = new TheGamesDb();
-  } else if(config.scraper == "arcadedb") {
-    scraper = new ArcadeDB();
-  } else if(config.scraper == "screenscraper") {
-    scraper = new ScreenScraper();
-  } else if(config.scraper == "worldofspectrum") {
-    scraper = new WorldOfSpectrum();
-  } else if(config.scraper == "localdb") {
-    scraper = new LocalScraper();
-  } else if(config.scraper == "import") {
-    scraper = new ImportScraper();
-  } else {
-    scraper = new AbstractScraper();
+  if(scraper == "openretro") {
+    return new OpenRetro();
+  } else if(scraper == "thegamesdb") {
+    return new TheGamesDb();
+  } else if(scraper == "arcadedb") {
+    return new ArcadeDB();
+  } else if(scraper == "screenscraper") {
+    return new ScreenScraper();
+  } else if(scraper == "worldofspectrum") {
+    return new WorldOfSpectrum();
+  } else if(scraper == "localdb") {
+    return new LocalScraper();
+  } else if(scraper == "import") {
+    return new ImportScraper();
   }
+  return new AbstractScraper();
+}
 
-  scraper->setConfig(&config);
-  scraper->loadMameMap();
-  
-  platformOrig = config.platform;
-  for(int a = beginIdx; a < filesPerThread + beginIdx; ++a) {
-    output = "";
-    config.platform = platformOrig;
-    QFileInfo info = inputFiles.at(a);
-    QString parNotes = "";
-    QString sqrNotes = "";
-    QString sha1 = getSha1(info);
-
-    QString compareName = scraper->getCompareName(info.completeBaseName(), sqrNotes, parNotes);
-
-    // Special markings for the platform, for instance 'AGA'
-    QString marking = ""; // No marking is default
-    // Special for Amiga platform where there are subplatforms in filename
-    if(config.platform == "amiga") {
-      if(info.completeBaseName().toLower().indexOf("cd32") != -1) {
-	config.platform = "cd32";
-      } else if(info.completeBaseName().toLower().indexOf("cdtv") != -1) {
-	config.platform = "cdtv";
-      } else if(info.completeBaseName().toLower().indexOf("aga") != -1) {
-	marking = "+aga";
-	config.platform = "aga";
-      }
+// Called once for every scraper the worker creates
+void ScraperWorker::setupScraper(AbstractScraper *)
+{
+}
+
+void ScraperWorker::clearScrapers()
+{
+  qDeleteAll(scrapers);
+  scrapers.clear();
+  qDeleteAll(configs);
+  configs.clear();
+}
+
+void ScraperWorker::run()
+{
+  ScrapeJob job;
+  while(scrapeQueue->takeJob(job, worker)) {
+    ScrapeTask task;
+    if(!startTask(job, task)) {
+      continue;
     }
-    
-    QList<GameEntry> gameEntries;
+    Settings *config = task.config;
+    // One file at a time, so the scraper can be told about the subplatform directly
+    config->platform = task.platform;
 
-    if(config.localDb && config.scraper == "localdb") {
-      if(localDb->hasSha1(sha1)) {
+    if(config->localDb && config->scraper == "localdb") {
+      QSharedPointer<LocalDb> localDb = job.run->localDb;
+      if(localDb->hasSha1(job.sha1)) {
 	GameEntry localGame;
-	localGame.sha1 = sha1;
+	localGame.sha1 = job.sha1;
 	localDb->fillBlanks(localGame);
 	if(localGame.title.isEmpty()) {
-	  localGame.title = compareName;
+	  localGame.title = task.compareName;
 	}
 	if(localGame.platform.isEmpty()) {
-	  localGame.platform = config.platform;
+	  localGame.platform = config->platform;
 	}
-	gameEntries.append(localGame);
+	task.gameEntries.append(localGame);
       }
     } else {
-      scraper->runPasses(gameEntries, info, output, marking);
+      task.scraper->runPasses(task.gameEntries, job.info, task.rom, task.output, task.marking);
     }
 
-    unsigned int lowestDistance = 666;
-    GameEntry game = getBestEntry(gameEntries, compareName, lowestDistance);
-    game.path = info.absoluteFilePath();
-    game.baseName = info.completeBaseName();
-    game.sha1 = sha1;
-    game.parNotes = parNotes;
-    game.sqrNotes = sqrNotes;
-
-    if(!game.found) {
-      output.append("\033[1;33m---- Game '" + info.completeBaseName() + "' not found :( ----\033[0m\n\n");
-      emit outputToTerminal(output);
-      emit entryReady(game);
-      continue;
-    }
-    int searchMatch = getSearchMatch(game.title, compareName, lowestDistance);
-    game.searchMatch = searchMatch;
-    if(searchMatch < config.minMatch) {
-      output.append("\033[1;33m---- Game '" + info.completeBaseName() + "' match too low :| ----\033[0m\n\n");
-      game.found = false;
-      emit outputToTerminal(output);
-      emit entryReady(game);
+    if(!matchTask(task)) {
       continue;
     }
-    output.append("\033[1;34m---- Game '" + info.completeBaseName() + "' found! :) ----\033[0m\n");
-    
-    scraper->getGameData(game);
+    task.scraper->getGameData(task.game);
+    completeTask(task);
+  }
+
+  clearScrapers();
+  emit allDone();
+}
 
-    if(game.title.toLower().left(4) == "the ") {
-      game.title = game.title.remove(0, 4).simplified().append(", The");
+// Sets up a task for the job with the settings and scraper of its platform. Returns
+// false if the job was dealt with right away, because it's a copy of a rom that is
+// already scraped, or a rom that was renamed since the last run
+bool ScraperWorker::startTask(const ScrapeJob &job, ScrapeTask &task)
+{
+  // Jobs of all platforms share the queue. Each platform gets its own settings and
+  // scraper
+  int index = job.run->index;
+  if(!scrapers.contains(index)) {
+    Settings *config = new Settings(job.run->config);
+    AbstractScraper *scraper = createScraper(config->scraper);
+    scraper->setConfig(config);
+    scraper->loadMameMap();
+    // The limits of the scraping module only apply to its own host
+    if(!scraper->getHost().isEmpty()) {
+      HostGovernor::setLimits(scraper->getHost(), config->requestLimits);
     }
+    setupScraper(scraper);
+    configs.insert(index, config);
+    scrapers.insert(index, scraper);
+  }
+  task.job = job;
+  task.config = configs.value(index);
+  task.scraper = scrapers.value(index);
+  task.platform = job.run->config.platform;
+
+  QFileInfo info = job.info;
+  task.compareName = task.scraper->getCompareName(info.completeBaseName(), task.sqrNotes,
+						  task.parNotes);
+  // Only the first copy of a rom, or the first disk of a game, is scraped. The
+  // others get its result. Local scrapers have data for each file, so they don't
+  // group disks
+  task.dupeKey = DupeTracker::getKey(job, task.compareName, task.parNotes,
+				     task.config->scraper != "localdb" &&
+				     task.config->scraper != "import");
+  GameEntry original;
+  DupeTracker::Claim claim = job.run->dupes->claim(task.dupeKey, job, original);
+  if(claim == DupeTracker::WAIT) {
+    return false;
+  } else if(claim == DupeTracker::COPY) {
+    addCopy(job, original, task.dupeKey, task.scraper);
+    return false;
+  }
+  // With '--incremental' a rom that was renamed since the last run keeps its result
+  GameEntry moved;
+  if(task.config->incremental && !job.run->manifest.isNull() &&
+     job.run->manifest->takeMoved(job.sha1, job.romSha1, moved)) {
+    addMoved(task, moved);
+    return false;
+  }
+  task.rom.sha1 = job.sha1;
+  task.rom.romSha1 = job.romSha1;
+  task.rom.romMd5 = job.romMd5;
+  task.rom.romCrc32 = job.romCrc32;
 
-    game.title = StrTools::xmlUnescape(game.title);
-    game.imageFile = StrTools::xmlUnescape(config.imagesFolder + "/" + info.completeBaseName() + ".png");
-    game.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
-    game.description = StrTools::xmlUnescape(game.description);
-    game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
-    game.developer = StrTools::xmlUnescape(game.developer);
-    game.publisher = StrTools::xmlUnescape(game.publisher);
-    game.tags = StrTools::xmlUnescape(game.tags);
-    game.rating = StrTools::xmlUnescape(game.rating);
-    game.players = StrTools::xmlUnescape(game.players);
-
-    if(config.verbose) {
-      output.append("Scraper:\t'" + config.scraper + "'\n");
+  // Special markings for the platform, for instance 'AGA'
+  // Special for Amiga platform where there are subplatforms in filename
+  if(task.platform == "amiga") {
+    if(info.completeBaseName().toLower().indexOf("cd32") != -1) {
+      task.platform = "cd32";
+    } else if(info.completeBaseName().toLower().indexOf("cdtv") != -1) {
+      task.platform = "cdtv";
+    } else if(info.completeBaseName().toLower().indexOf("aga") != -1) {
+      task.marking = "+aga";
+      task.platform = "aga";
     }
-    output.append("Search match:\t" + QString::number(searchMatch) + " %\n");
-    output.append("Web title:\t'" + game.title + "'\n");
-    output.append("Compare title:\t'" + compareName + "'\n");
-    output.append("Platform:\t'" + game.platform + "'\n");
-    output.append("Release Date:\t'");
-    if(game.releaseDate.isEmpty()) {
-      output.append("'\n");
+  }
+  return true;
+}
+
+// Picks the best of the search results. Returns false if none of them are good
+// enough, in which case the task is finished as not found
+bool ScraperWorker::matchTask(ScrapeTask &task)
+{
+  QFileInfo info = task.job.info;
+  unsigned int lowestDistance = 666;
+  GameEntry &game = task.game;
+  game = getBestEntry(task.gameEntries, task.compareName, lowestDistance);
+  game.path = info.absoluteFilePath();
+  game.baseName = info.completeBaseName();
+  game.sha1 = task.job.sha1;
+  game.romSha1 = task.rom.romSha1;
+  game.romMd5 = task.rom.romMd5;
+  game.romCrc32 = task.rom.romCrc32;
+  game.parNotes = task.parNotes;
+  game.sqrNotes = task.sqrNotes;
+
+  if(!game.found) {
+    task.output.append("\033[1;33m---- Game '" + info.completeBaseName() + "' not found :( ----\033[0m\n\n");
+    finishEntry(task);
+    return false;
+  }
+  int searchMatch = getSearchMatch(game.title, task.compareName, lowestDistance,
+				   task.config->minMatch);
+  game.searchMatch = searchMatch;
+  if(searchMatch < task.config->minMatch) {
+    task.output.append("\033[1;33m---- Game '" + info.completeBaseName() + "' match too low :| ----\033[0m\n\n");
+    game.found = false;
+    finishEntry(task);
+    return false;
+  }
+  task.output.append("\033[1;34m---- Game '" + info.completeBaseName() + "' found! :) ----\033[0m\n");
+  return true;
+}
+
+// Cleans up the scraped game data and hands the game on to the write stage
+void ScraperWorker::completeTask(ScrapeTask &task)
+{
+  QFileInfo info = task.job.info;
+  Settings *config = task.config;
+  GameEntry &game = task.game;
+  QString &output = task.output;
+
+  if(game.title.toLower().left(4) == "the ") {
+    game.title = game.title.remove(0, 4).simplified().append(", The");
+  }
+
+  game.title = StrTools::xmlUnescape(game.title);
+  game.imageFile = StrTools::xmlUnescape(config->imagesFolder + "/" + info.completeBaseName() + ".png");
+  game.videoFile = StrTools::xmlUnescape(config->videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
+  game.description = StrTools::xmlUnescape(game.description);
+  game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
+  game.developer = StrTools::xmlUnescape(game.developer);
+  game.publisher = StrTools::xmlUnescape(game.publisher);
+  game.tags = StrTools::xmlUnescape(game.tags);
+  game.rating = StrTools::xmlUnescape(game.rating);
+  game.players = StrTools::xmlUnescape(game.players);
+
+  if(config->verbose) {
+    output.append("Scraper:\t'" + config->scraper + "'\n");
+  }
+  output.append("Search match:\t" + QString::number(game.searchMatch) + " %\n");
+  output.append("Web title:\t'" + game.title + "'\n");
+  output.append("Compare title:\t'" + task.compareName + "'\n");
+  output.append("Platform:\t'" + game.platform + "'\n");
+  output.append("Release Date:\t'");
+  if(game.releaseDate.isEmpty()) {
+    output.append("'\n");
+  } else {
+    if(game.releaseDate.toInt() == 0) {
+      output.append("Unknown format (" + game.releaseDate + ")'\n");
     } else {
-      if(game.releaseDate.toInt() == 0) {
-	output.append("Unknown format (" + game.releaseDate + ")'\n");
-      } else {
-	output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "'\n");
-      }
-    }
-    output.append("Developer:\t'" + game.developer + "'\n");
-    output.append("Publisher:\t'" + game.publisher + "'\n");
-    output.append("Players:\t'" + game.players + "'\n");
-    output.append("Tags:\t\t'" + game.tags + "'\n");
-    output.append("Rating (0-1):\t'" + game.rating + "'\n");
-    output.append("Cover:\t\t" + QString((game.coverData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
-    output.append("Screenshot:\t" + QString((game.screenshotData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
-    if(config.videos) {
-      output.append("Video:\t\t" + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
-    }
-    output.append("\nDescription:\n" + game.description + "\n");
-
-    if(!config.pretend) {
-      if(config.frontend != "attractmode") {
-	Compositor artCreator;
-	artCreator.composite(game.coverData, game.screenshotData, config).save(config.imagesFolder + "/" + info.completeBaseName() + ".png");
-      } else {
-	game.screenshotData.save(config.imagesFolder + "/" + info.completeBaseName() + ".png");
-      }
+      output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "'\n");
     }
+  }
+  output.append("Developer:\t'" + game.developer + "'\n");
+  output.append("Publisher:\t'" + game.publisher + "'\n");
+  output.append("Players:\t'" + game.players + "'\n");
+  output.append("Tags:\t\t'" + game.tags + "'\n");
+  output.append("Rating (0-1):\t'" + game.rating + "'\n");
+  output.append("Cover:\t\t" + QString((game.coverData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
+  output.append("Screenshot:\t" + QString((game.screenshotData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
+  if(config->videos) {
+    output.append("Video:\t\t" + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m\n");
+  }
+  output.append("\nDescription:\n" + game.description + "\n");
 
-    if(config.videos && game.videoFormat != "") {
-      QFile videoFile(config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
-      if(videoFile.open(QIODevice::WriteOnly)) {
-	videoFile.write(game.videoData);
-	videoFile.close();
-      }
-    }
+  // Compositing and writing of media is handled by the write stage threads
+  finishEntry(task);
+}
 
-    if(config.localDb && config.scraper != "localdb" && !config.pretend && game.found) {
-      game.source = config.scraper;
-      localDb->addResources(game, config.updateDb);
-    }
+void ScraperWorker::finishEntry(const ScrapeTask &task)
+{
+  writeStage->addEntry(task.game, task.job.run);
+  emit outputToTerminal(task.output);
+  emit entryReady(task.game, task.job.run->index);
 
-    emit outputToTerminal(output);
-    emit entryReady(game);
+  // Copies of the rom, or other disks of the game, that turned up while it was
+  // being scraped
+  foreach(const ScrapeJob &job, task.job.run->dupes->scraped(task.dupeKey, task.game)) {
+    addCopy(job, task.game, task.dupeKey, task.scraper);
   }
+}
 
-  delete scraper;
-  emit allDone();
+// Gives a copy of a rom, or another disk of a game, the result of the original.
+// Media files and db resources are shared with the original by the write stage
+void ScraperWorker::addCopy(const ScrapeJob &job, const GameEntry &original,
+			    const QString &dupeKey, AbstractScraper *scraper)
+{
+  const Settings &config = job.run->config;
+  QFileInfo info = job.info;
+  GameEntry copy = original;
+  QString parNotes = "";
+  QString sqrNotes = "";
+  QString compareName = scraper->getCompareName(info.completeBaseName(), sqrNotes, parNotes);
+  copy.path = info.absoluteFilePath();
+  copy.baseName = info.completeBaseName();
+  copy.sha1 = job.sha1;
+  copy.romSha1 = job.romSha1;
+  copy.romMd5 = job.romMd5;
+  copy.romCrc32 = job.romCrc32;
+  copy.parNotes = parNotes;
+  copy.sqrNotes = sqrNotes;
+
+  QString copyOutput = "";
+  if(copy.found) {
+    copy.imageFile = StrTools::xmlUnescape(config.imagesFolder + "/" + info.completeBaseName() + ".png");
+    copy.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" + info.completeBaseName() + "." + copy.videoFormat);
+    copy.mediaSource = original.baseName;
+    copy.originalSha1 = original.sha1;
+    copyOutput.append("\033[1;34m---- Game '" + info.completeBaseName() + "' is " + (DupeTracker::isDiskKey(dupeKey)?"another disk":"a copy") + " of '" + original.baseName + "', using its result ----\033[0m\n\n");
+  } else {
+    copy.title = compareName;
+    copyOutput.append("\033[1;33m---- Game '" + info.completeBaseName() + "' is " + (DupeTracker::isDiskKey(dupeKey)?"another disk":"a copy") + " of '" + original.baseName + "' which wasn't found :( ----\033[0m\n\n");
+  }
+
+  writeStage->addEntry(copy, job.run);
+  emit outputToTerminal(copyOutput);
+  emit entryReady(copy, job.run->index);
+}
+
+// Gives a renamed rom the result it had under its old name. The write stage
+// renames its media files to match
+void ScraperWorker::addMoved(ScrapeTask &task, const GameEntry &moved)
+{
+  const ScrapeJob &job = task.job;
+  QFileInfo info = job.info;
+  GameEntry &game = task.game;
+  game = moved;
+  game.path = info.absoluteFilePath();
+  game.baseName = info.completeBaseName();
+  game.sha1 = job.sha1;
+  game.originalSha1 = moved.sha1;
+  game.romSha1 = job.romSha1;
+  game.romMd5 = job.romMd5;
+  game.romCrc32 = job.romCrc32;
+  game.parNotes = task.parNotes;
+  game.sqrNotes = task.sqrNotes;
+  if(game.found) {
+    game.imageFile = StrTools::xmlUnescape(task.config->imagesFolder + "/" + info.completeBaseName() + ".png");
+    game.videoFile = StrTools::xmlUnescape(task.config->videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
+    game.movedFrom = moved.baseName;
+  }
+
+  task.output = "\033[1;34m---- Game '" + info.completeBaseName() + "' was renamed from '" + moved.baseName + "', using its result ----\033[0m\n\n";
+  finishEntry(task);
 }
 
 int ScraperWorker::getSearchMatch(const QString &title, const QString &compareName,
-				  const int &lowestDistance)
+				  const int &lowestDistance, const int &minMatch)
 {
   int searchMatch = 0;
   if(title.length() > compareName.length()) {
@@ -234,7 +374,7 @@ int ScraperWorker::getSearchMatch(const QString &title, const QString &compareNa
 			((double)compareName.length() - (double)lowestDistance));
   }
   // Special case where result is actually correct, but gets low match because of the prepending of, for instance, "Disney's [title]" where the fileName is just "[title]". Accept these if searchMatch is 'similar enough' (above 50)
-  if(searchMatch < config.minMatch) {
+  if(searchMatch < minMatch) {
     if(title.toLower().indexOf(compareName.toLower()) != -1 && searchMatch >= 50) {
       searchMatch = 100;
     }
@@ -260,41 +400,6 @@ unsigned int ScraperWorker::editDistance(const std::string& s1, const std::strin
   return prevCol[len2];
 }
 
-QString ScraperWorker::getSha1(const QFileInfo &info)
-{
-  QCryptographicHash sha1(QCryptographicHash::Sha1);
-
-  // If file is some sort of script or a zip file, use filename for sha1
-  bool sha1FromData = true;
-  if(info.suffix() == "uae" || info.suffix() == "cue" ||
-     info.suffix() == "sh" || info.suffix() == "svm" ||
-     info.suffix() == "mds" || info.suffix() == "svm" ||
-     info.suffix() == "zip") {
-    sha1FromData = false;
-  }
-  // If file is larger than 50 MBs, use filename for sha1
-  if(info.size() > 52428800) {
-    sha1FromData = false;
-  }
-
-  if(sha1FromData) {
-    QFile romFile(info.absoluteFilePath());
-    if(romFile.open(QIODevice::ReadOnly)) {
-      while(!romFile.atEnd()) {
-	sha1.addData(romFile.read(1024));
-      }
-      romFile.close();
-    } else {
-      printf("Couldn't calculate sha1 hash sum of rom file '%s', please check permissions and try again, now exiting...\n", info.fileName().toStdString().c_str());
-      exit(1);
-    }
-  } else {
-    sha1.addData(info.fileName().toUtf8());
-  }
-
-  return sha1.result().toHex();
-}
-
 GameEntry ScraperWorker::getBestEntry(const QList<GameEntry> &gameEntries,
 				      const QString &compareName, unsigned int &lowestDistance)
 {
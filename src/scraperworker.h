@@ -33,43 +33,80 @@
 #include "abstractscraper.h"
 #include "settings.h"
 #include "localdb.h"
+#include "scrapequeue.h"
+#include "writestage.h"
+#include "dupetracker.h"
+#include "manifest.h"
+#include "platformrun.h"
+
+// A file on its way through a worker. The threaded workers handle one at a time,
+// the async worker keeps many of them going at once
+struct ScrapeTask {
+  ScrapeJob job;
+  Settings *config = nullptr; // Settings of the worker's copy of the platform
+  AbstractScraper *scraper = nullptr;
+  QString platform = ""; // Might be a subplatform, for instance 'aga' for 'amiga'
+  QString compareName = "";
+  QString sqrNotes = "";
+  QString parNotes = "";
+  QString marking = "";
+  QString dupeKey = "";
+  QString output = "";
+  GameEntry rom;
+  QList<GameEntry> gameEntries;
+  GameEntry game;
+  // Only used by the async worker
+  int pass = 0;
+  QByteArray searchData;
+  QList<QPair<int, NetReply *> > fetchPlan;
+};
 
 class ScraperWorker : public QObject
 {
   Q_OBJECT
 
 public:
-  ScraperWorker(QList<QFileInfo> inputFiles, int filesPerThreads, int beginIdx,
-		Settings config, QSharedPointer<LocalDb> localDb);
+  ScraperWorker(QSharedPointer<ScrapeQueue> scrapeQueue, QSharedPointer<WriteStage> writeStage,
+		int worker);
   ~ScraperWorker();
-  void run();
+  virtual void run();
+  static AbstractScraper *createScraper(const QString &scraper);
   
 signals:
   void allDone();
-  void entryReady(const GameEntry &entry);
+  void entryReady(const GameEntry &entry, int platformIndex);
   //void addToSkipped(const QString &gameBaseName, const QString &closestMatch);
   void outputToTerminal(const QString &text);
 
+protected:
+  QSharedPointer<ScrapeQueue> scrapeQueue;
+  QSharedPointer<WriteStage> writeStage;
+  // One scraper and settings per platform, as they load platform specific data
+  QMap<int, AbstractScraper*> scrapers;
+  QMap<int, Settings*> configs;
+  int worker;
+
+  virtual void setupScraper(AbstractScraper *scraper);
+  bool startTask(const ScrapeJob &job, ScrapeTask &task);
+  bool matchTask(ScrapeTask &task);
+  void completeTask(ScrapeTask &task);
+  void clearScrapers();
+
 private:
-  QSharedPointer<LocalDb> localDb;
-  
-  Settings config;
-  QString platformOrig;
-  QString output;
-  QList<QFileInfo> inputFiles;
-  int filesPerThread;
-  int beginIdx;
-  
   unsigned int editDistance(const std::string& s1, const std::string& s2);
   void nomNom(QByteArray &data, const QString nom, bool including = true);
 
   void getSearchResults(QList<GameEntry> &gameEntries, QString searchName, QString platform);
   void getGameData(GameEntry &game);
   QString assembleTags(QByteArray &data);
-  QString getSha1(const QFileInfo &info);
   GameEntry getBestEntry(const QList<GameEntry> &gameEntries, const QString &compareName,
 			 unsigned int &lowestDistance);
-  int getSearchMatch(const QString &title, const QString &compareName, const int &lowestDistance);
+  int getSearchMatch(const QString &title, const QString &compareName, const int &lowestDistance,
+		     const int &minMatch);
+  void finishEntry(const ScrapeTask &task);
+  void addCopy(const ScrapeJob &job, const GameEntry &original, const QString &dupeKey,
+	       AbstractScraper *scraper);
+  void addMoved(ScrapeTask &task, const GameEntry &moved);
 };
 
 #endif // SCRAPERWORKER_H
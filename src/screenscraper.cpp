@@ -54,11 +54,23 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
     exit(1);
   }
   */
-  QString gameUrl = "https://www.screenscraper.fr/api/jeuInfos.php?devid=muldjord&devpassword=" + StrTools::unMagic("204;198;236;130;203;181;203;126;191;167;200;198;192;228;169;156") + "&softname=skyscraper" VERSION "&output=xml&" + searchName;
+  QString gameUrl = getGameUrl(searchName);
   manager.request(gameUrl);
   q.exec();
   data = manager.getData();
 
+  parseSearchResults(gameEntries, gameUrl, data, platform);
+}
+
+QString ScreenScraper::getGameUrl(const QString &searchName)
+{
+  return "https://www.screenscraper.fr/api/jeuInfos.php?devid=muldjord&devpassword=" + StrTools::unMagic("204;198;236;130;203;181;203;126;191;167;200;198;192;228;169;156") + "&softname=skyscraper" VERSION "&output=xml&" + searchName;
+}
+
+// The search reply holds all of the game data, so the game url is never requested
+void ScreenScraper::parseSearchResults(QList<GameEntry> &gameEntries, const QString &query,
+				       const QByteArray &data, const QString &platform)
+{
   if(data.indexOf("Erreur") != -1) {
     return;
   }
@@ -84,7 +96,7 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
     return;
   }
 
-  game.url = gameUrl;
+  game.url = query;
   
   game.platform = xmlDoc.elementsByTagName("systemenom").at(0).toElement().text();
   
@@ -93,7 +105,54 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
   }
 }
 
+bool ScreenScraper::supportsAsync()
+{
+  return true;
+}
+
+QString ScreenScraper::getPassQuery(const int &pass, const QFileInfo &info, const GameEntry &rom)
+{
+  QString searchName = getPassSearchName(pass, info, rom);
+  if(searchName.isEmpty()) {
+    return "";
+  }
+  return getGameUrl(searchName);
+}
+
+// Each pass looks the rom up by a different checksum, and lastly by its file name
+QString ScreenScraper::getPassSearchName(const int &pass, const QFileInfo &info,
+					 const GameEntry &rom)
+{
+  switch(pass) {
+  case 1:
+    return "md5=" + rom.romMd5.toUpper();
+  case 2:
+    return "sha1=" + rom.romSha1.toUpper();
+  case 3:
+    // Some dumps are only known by their crc
+    return "crc=" + rom.romCrc32.toUpper();
+  case 4:
+    return "romnom=" + QUrl::toPercentEncoding(info.fileName());
+  default:
+    ;
+  }
+  return "";
+}
+
+void ScreenScraper::parseGameData(GameEntry &game, const QByteArray &data)
+{
+  xmlDoc.setContent(data);
+  getGameFields(game);
+}
+
+// The game data is already there from the search, only the media is downloaded
 void ScreenScraper::getGameData(GameEntry &game)
+{
+  getGameFields(game);
+  runFetchPlan(game);
+}
+
+void ScreenScraper::getGameFields(GameEntry &game)
 {
   for(int a = 0; a < fetchOrder.length(); ++a) {
     switch(fetchOrder.at(a)) {
@@ -254,7 +313,7 @@ void ScreenScraper::getTags(GameEntry &game)
   game.tags = game.tags.left(game.tags.length() - 2);
 }
 
-void ScreenScraper::getCover(GameEntry &game)
+void ScreenScraper::getCover(GameEntry &)
 {
   QDomElement xmlElem;
   xmlElem = xmlDoc.elementsByTagName("media_box2d_" + config->region).at(0).toElement();
@@ -268,36 +327,31 @@ void ScreenScraper::getCover(GameEntry &game)
     xmlElem = xmlDoc.elementsByTagName("media_box2d_us").at(0).toElement();
   }
   if(!xmlElem.isNull()) {
-    manager.request(xmlElem.text());
-    q.exec();
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.coverData = image;
-    }
+    addToFetchPlan(COVER, xmlElem.text());
   }
 }
 
-void ScreenScraper::getScreenshot(GameEntry &game)
+void ScreenScraper::getScreenshot(GameEntry &)
 {
   QDomElement xmlElem = xmlDoc.elementsByTagName("media_screenshot").at(0).toElement();
   if(!xmlElem.isNull()) {
-    manager.request(xmlElem.text());
-    q.exec();
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.screenshotData = image;
-    }
+    addToFetchPlan(SCREENSHOT, xmlElem.text());
   }
 }
 
-void ScreenScraper::getVideo(GameEntry &game)
+void ScreenScraper::getVideo(GameEntry &)
 {
   QDomElement xmlElem = xmlDoc.elementsByTagName("media_video").at(0).toElement();
-  manager.request(xmlElem.text());
-  q.exec();
-  game.videoData = manager.getData();
+  if(!xmlElem.isNull()) {
+    addToFetchPlan(VIDEO, xmlElem.text());
+  }
+}
+
+void ScreenScraper::setVideoData(GameEntry &game, NetReply *netReply)
+{
+  game.videoData = netReply->getData();
   // Make sure recieved data is actually a video file
-  QByteArray contentType = manager.getContentType();
+  QByteArray contentType = netReply->getContentType();
   if(contentType.indexOf("video/") != -1 && game.videoData.size() > 4096) {
     game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
 				       contentType.length() - contentType.indexOf("/") + 1);
@@ -306,44 +360,14 @@ void ScreenScraper::getVideo(GameEntry &game)
   } 
 }
 
-void ScreenScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &output, QString &)
+// Rom checksums are calculated by the hashing stage, so the rom is never read here
+void ScreenScraper::runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &rom, QString &output, QString &)
 {
-  QString hashes = getHashes(info);
-  QList<QString> hashList = hashes.split(":");
-
-  for(int pass = 1; pass <= 3; ++pass) {
+  for(int pass = 1; pass <= 4; ++pass) {
     output.append("\033[1;35mPass " + QString::number(pass) + "\033[0m ");
-    switch(pass) {
-    case 1:
-      getSearchResults(gameEntries, "md5=" + hashList.at(1), config->platform);
-      break;
-    case 2:
-      getSearchResults(gameEntries, "sha1=" + hashList.at(2), config->platform);
-      break;
-    case 3:
-      getSearchResults(gameEntries, "romnom=" + hashList.at(0), config->platform);
-      break;
-    default:
-      ;
-    }
+    getSearchResults(gameEntries, getPassSearchName(pass, info, rom), config->platform);
     if(!gameEntries.isEmpty()) {
       break;
     }
   }
 }
-
-QString ScreenScraper::getHashes(const QFileInfo &info)
-{
-  QCryptographicHash md5(QCryptographicHash::Md5);
-  QCryptographicHash sha1(QCryptographicHash::Sha1);
-  QFile romFile(info.absoluteFilePath());
-  romFile.open(QIODevice::ReadOnly);
-  while(!romFile.atEnd()) {
-    QByteArray dataSeg = romFile.read(1024);
-    md5.addData(dataSeg);
-    sha1.addData(dataSeg);
-  }
-  romFile.close();
-
-  return QUrl::toPercentEncoding(info.fileName()) + ":" + md5.result().toHex().toUpper() + ":" + sha1.result().toHex().toUpper();
-}
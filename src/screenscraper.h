@@ -36,12 +36,18 @@ class ScreenScraper : public AbstractScraper
 
 public:
   ScreenScraper();
-  void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, QString &output, QString &marking);
+  void runPasses(QList<GameEntry> &gameEntries, const QFileInfo &info, const GameEntry &rom, QString &output, QString &marking);
+  bool supportsAsync();
+  QString getPassQuery(const int &pass, const QFileInfo &info, const GameEntry &rom);
+  void parseSearchResults(QList<GameEntry> &gameEntries, const QString &query,
+			  const QByteArray &data, const QString &platform);
+  void parseGameData(GameEntry &game, const QByteArray &data);
 
 private:
   void getSearchResults(QList<GameEntry> &gameEntries,
 			QString searchName, QString platform);
   void getGameData(GameEntry &game);
+  void getGameFields(GameEntry &game);
   void getReleaseDate(GameEntry &game);
   void getDeveloper(GameEntry &game);
   void getPublisher(GameEntry &game);
@@ -52,7 +58,9 @@ private:
   void getCover(GameEntry &game);
   void getScreenshot(GameEntry &game);
   void getVideo(GameEntry &game);
-  QString getHashes(const QFileInfo &info);
+  void setVideoData(GameEntry &game, NetReply *netReply);
+  QString getGameUrl(const QString &searchName);
+  QString getPassSearchName(const int &pass, const QFileInfo &info, const GameEntry &rom);
 
   QString region;
   QString lang;
@@ -26,6 +26,15 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include <QString>
+#include <QMap>
+
+// Limits for the requests made to a single host, 0 means no limit
+struct HostLimits {
+  double requestsPerSecond = 0.0;
+  int maxInFlight = 0;
+};
+
 struct Settings {
   QString dbFolder = "";
   QString gameListFileString = "";
@@ -42,6 +51,14 @@ struct Settings {
   QString videosFolder = "";
   int doneThreads = 0;
   int threads = 4;
+  bool autoThreads = false;
+  bool asyncThreads = false;
+  int hashThreads = 2;
+  int writeThreads = 2;
+  int inFlight = 16;
+  // Limits of the host the scraping module talks to, and of any other hosts
+  HostLimits requestLimits;
+  QMap<QString, HostLimits> hostLimits;
   int minMatch = 50;
   int notFound = 0;
   int found = 0;
@@ -54,10 +71,16 @@ struct Settings {
   bool updateDb = false;
   bool checkDb = false;
   bool cleanDb = false;
+  bool exportDb = false;
+  QString dbFormat = "xml";
   QString mergeDb = "";
   bool subDirs = true;
   bool pretend = false;
   bool unattend = false;
+  bool resume = false;
+  bool incremental = false;
+  bool watch = false;
+  bool rehash = false;
   bool stats = false;
   bool verbose = false;
   bool skipped = false;
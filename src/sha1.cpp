@@ -0,0 +1,157 @@
+/***************************************************************************
+ *            sha1.cpp
+ *
+ *  Wed Jan 17 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include <cstring>
+
+#include "sha1.h"
+#include "hashkernels.h"
+
+struct Sha1Kernel {
+  QString name;
+  void (*blocks)(quint32 *state, const uchar *data, qint64 count);
+};
+
+// The fastest kernel the cpu supports is picked the first time it's needed
+static Sha1Kernel &currentKernel()
+{
+  static Sha1Kernel kernel = [] {
+    Sha1Kernel best = { "qt", nullptr };
+    if(HashKernels::hasShaNi()) {
+      best = { "sha-ni", HashKernels::sha1ShaNi };
+    } else if(HashKernels::hasArmSha1()) {
+      best = { "armv8-ce", HashKernels::sha1ArmCe };
+    }
+    return best;
+  }();
+  return kernel;
+}
+
+Sha1::Sha1() : fallback(QCryptographicHash::Sha1)
+{
+  reset();
+}
+
+void Sha1::reset()
+{
+  blocks = currentKernel().blocks;
+  fallback.reset();
+  state[0] = 0x67452301;
+  state[1] = 0xefcdab89;
+  state[2] = 0x98badcfe;
+  state[3] = 0x10325476;
+  state[4] = 0xc3d2e1f0;
+  bufferLength = 0;
+  totalLength = 0;
+}
+
+void Sha1::addData(const char *data, qint64 length)
+{
+  if(blocks == nullptr) {
+    fallback.addData(data, length);
+    return;
+  }
+  const uchar *bytes = (const uchar *)data;
+  totalLength += length;
+  // Finish a block left over from last time first
+  if(bufferLength > 0) {
+    int needed = qMin((qint64)(64 - bufferLength), length);
+    memcpy(buffer + bufferLength, bytes, needed);
+    bufferLength += needed;
+    bytes += needed;
+    length -= needed;
+    if(bufferLength < 64) {
+      return;
+    }
+    blocks(state, buffer, 1);
+    bufferLength = 0;
+  }
+  if(length >= 64) {
+    blocks(state, bytes, length / 64);
+    bytes += length - length % 64;
+    length %= 64;
+  }
+  memcpy(buffer, bytes, length);
+  bufferLength = length;
+}
+
+QByteArray Sha1::result()
+{
+  if(blocks == nullptr) {
+    return fallback.result();
+  }
+  // Pad a copy, so more data can still be added afterwards
+  quint32 resultState[5];
+  memcpy(resultState, state, sizeof(state));
+  uchar padding[128] = { 0 };
+  memcpy(padding, buffer, bufferLength);
+  padding[bufferLength] = 0x80;
+  int paddedLength = (bufferLength < 56?64:128);
+  quint64 bits = totalLength * 8;
+  for(int a = 0; a < 8; ++a) {
+    padding[paddedLength - 1 - a] = (uchar)(bits >> (a * 8));
+  }
+  blocks(resultState, padding, paddedLength / 64);
+
+  QByteArray digest(20, '\0');
+  for(int a = 0; a < 20; ++a) {
+    digest[a] = (char)(resultState[a / 4] >> (24 - (a % 4) * 8));
+  }
+  return digest;
+}
+
+// Kernels usable on this cpu. 'qt' is QCryptographicHash and always available
+QList<QString> Sha1::getKernels()
+{
+  QList<QString> kernels;
+  if(HashKernels::hasShaNi()) {
+    kernels.append("sha-ni");
+  }
+  if(HashKernels::hasArmSha1()) {
+    kernels.append("armv8-ce");
+  }
+  kernels.append("qt");
+  return kernels;
+}
+
+// Only meant for benchmarking. Affects Sha1 objects created or reset after this
+bool Sha1::setKernel(const QString &name)
+{
+  if(name == "sha-ni" && HashKernels::hasShaNi()) {
+    currentKernel() = { name, HashKernels::sha1ShaNi };
+  } else if(name == "armv8-ce" && HashKernels::hasArmSha1()) {
+    currentKernel() = { name, HashKernels::sha1ArmCe };
+  } else if(name == "qt") {
+    currentKernel() = { name, nullptr };
+  } else {
+    return false;
+  }
+  return true;
+}
+
+QString Sha1::getKernel()
+{
+  return currentKernel().name;
+}
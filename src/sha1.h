@@ -0,0 +1,58 @@
+/***************************************************************************
+ *            sha1.h
+ *
+ *  Wed Jan 17 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QList>
+#include <QString>
+
+// Drop-in for QCryptographicHash(Sha1) used on rom data. Uses the sha instructions
+// of the cpu when it has them, which is several times faster.
+class Sha1
+{
+public:
+  Sha1();
+  void reset();
+  void addData(const char *data, qint64 length);
+  QByteArray result();
+  static QList<QString> getKernels();
+  static bool setKernel(const QString &name);
+  static QString getKernel();
+
+private:
+  void (*blocks)(quint32 *state, const uchar *data, qint64 count);
+  QCryptographicHash fallback;
+  quint32 state[5];
+  uchar buffer[64];
+  int bufferLength;
+  quint64 totalLength;
+
+};
+
+#endif // SHA1_H
@@ -29,6 +29,9 @@
 #include <QSettings>
 #include <QDirIterator>
 #include <QTimer>
+#include <QSet>
+#include <QSaveFile>
+#include <QDateTime>
 
 #include "skyscraper.h"
 #include "xmlreader.h"
@@ -42,16 +45,125 @@ Skyscraper::Skyscraper(const QCommandLineParser &parser)
   qRegisterMetaType<GameEntry>("GameEntry");
   
   printf("\033[1;34m------------------------------------------\033[0m\n\033[1;33mRunning Skyscraper v" VERSION " by Lars Muldjord\033[0m\n\033[1;34m------------------------------------------\033[0m\n");
-  loadConfig(parser);
+
+  this->parser = &parser;
+  connect(&tuneTimer, &QTimer::timeout, this, &Skyscraper::tuneThreads);
+  scraping = false;
+  rescanPending = false;
+  watchTimer.setSingleShot(true);
+  watchTimer.setInterval(2000);
+  connect(&watchTimer, &QTimer::timeout, this, &Skyscraper::rescanInput);
+  connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &Skyscraper::inputChanged);
+
+  // '-p' takes a single platform, a comma separated list of platforms or 'all'.
+  // The files of all the platforms are scraped together by the same threads
+  if(parser.isSet("p")) {
+    if(parser.value("p") == "all") {
+      platforms = Platform::getPlatforms();
+    } else {
+      platforms = parser.value("p").split(",", QString::SkipEmptyParts);
+    }
+  }
+  if(platforms.isEmpty()) {
+    printf("Please set a valid platform with '-p [platform]'\nCheck '--help' for a list of supported platforms, now exiting...\n");
+    exit(1);
+  }
+  for(int a = 0; a < platforms.length(); ++a) {
+    platforms[a] = platforms.at(a).trimmed();
+    if(!Platform::getPlatforms().contains(platforms.at(a))) {
+      printf("Platform '%s' isn't supported.\nCheck '--help' for a list of supported platforms, now exiting...\n", platforms.at(a).toStdString().c_str());
+      exit(1);
+    }
+  }
+  batchMode = (platforms.length() > 1);
+  if(batchMode && parser.isSet("watch")) {
+    printf("'--watch' can only be used with a single platform, now exiting...\n");
+    exit(1);
+  }
+
+  installFiles();
 }
 
 Skyscraper::~Skyscraper()
 {
-  delete frontend;
 }
 
 void Skyscraper::run()
 {
+  // Db maintenance doesn't scrape anything. It's done for every db folder of the
+  // chosen platforms
+  if(parser->isSet("cleandb") || parser->isSet("exportdb") || parser->isSet("mergedb")) {
+    runDbOperations();
+    exit(0);
+  }
+
+  // Platforms are prepared one at a time, as they might ask the user questions.
+  // Their files are then scraped in one go
+  QList<ScrapeJob> jobs;
+  foreach(QString platform, platforms) {
+    if(platform != platforms.first()) {
+      printf("\033[1;34m---- Moving on to next platform ----\033[0m\n");
+    }
+    QSharedPointer<PlatformRun> platformRun = QSharedPointer<PlatformRun>(new PlatformRun());
+    loadConfig(*parser, platform, *platformRun);
+    QList<QFileInfo> inputFiles;
+    if(!prepareRun(*platformRun, inputFiles)) {
+      continue;
+    }
+    platformRun->index = runs.length();
+    runs.append(platformRun);
+    addJobs(jobs, inputFiles, platformRun);
+  }
+  if(runs.isEmpty()) {
+    printf("No platforms left to scrape, now exiting...\n");
+    emit finished();
+    return;
+  }
+
+  // The threads are shared by all platforms, so they get the largest number of
+  // threads any of them is set to. The requests to each host are limited no
+  // matter how many threads there are
+  threadsSetting = 1;
+  autoThreads = false;
+  asyncThreads = false;
+  foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+    threadsSetting = qMax(threadsSetting, platformRun->config.threads);
+    if(platformRun->config.autoThreads) {
+      autoThreads = true;
+    }
+    if(platformRun->config.asyncThreads) {
+      asyncThreads = true;
+    }
+  }
+  // The async worker scrapes the files of all platforms, so their scraping modules
+  // must all support it
+  if(asyncThreads) {
+    foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+      AbstractScraper *scraper = ScraperWorker::createScraper(platformRun->config.scraper);
+      bool supportsAsync = scraper->supportsAsync();
+      delete scraper;
+      if(!supportsAsync) {
+	printf("Scraping module '\033[1;32m%s\033[0m' can't scrape asynchronously, using \033[1;32m%d\033[0m threads instead.\n", platformRun->config.scraper.toStdString().c_str(), threadsSetting);
+	asyncThreads = false;
+	break;
+      }
+    }
+  }
+  if(asyncThreads) {
+    threadsSetting = 1;
+    autoThreads = false;
+  }
+
+  scrapeFiles(jobs);
+}
+
+// Sets up the folders, db, gamelist, manifest and journal of a platform and finds
+// the files that need scraping. Returns false if the platform is skipped
+bool Skyscraper::prepareRun(PlatformRun &platformRun, QList<QFileInfo> &inputFiles)
+{
+  Settings &config = platformRun.config;
+  QSharedPointer<AbstractFrontend> frontend = platformRun.frontend;
+
   printf("Platform        : '\033[1;32m%s\033[0m'\n", config.platform.toStdString().c_str());
   printf("Scraper module  : '\033[1;32m%s\033[0m'\n", config.scraper.toStdString().c_str());
   if(config.emulator != "") {
@@ -67,20 +179,26 @@ void Skyscraper::run()
     printf("Local db folder : '\033[1;32m%s\033[0m'\n\n", config.dbFolder.toStdString().c_str());
   }
   
-  if(config.scraper == "arcadedb" && config.threads != 1) {
-    printf("Forcing 1 thread to accomodate limits in ArcadeDB scraping module\n\n");
-    config.threads = 1;
+  // Requests to each host are limited across all threads. The limits of the
+  // scraping module itself are set by the scraper threads, since only the module
+  // knows which host it talks to
+  printLimits("'\033[1;32m" + config.scraper + "\033[0m' scraping module", config.requestLimits);
+  foreach(QString host, config.hostLimits.keys()) {
+    HostGovernor::setLimits(host, config.hostLimits.value(host));
+    printLimits("host '\033[1;32m" + host + "\033[0m'", config.hostLimits.value(host));
+  }
+  if(config.requestLimits.requestsPerSecond > 0.0 || config.requestLimits.maxInFlight > 0 ||
+     !config.hostLimits.isEmpty()) {
+    printf("\n");
   }
 
-  doneThreads = 0;
-  notFound = 0;
-  found = 0;
-  avgCompleteness = 0;
-  avgSearchMatch = 0;
-  
   QDir inputDir(config.inputFolder, Platform::getFormats(config.platform), QDir::Name, QDir::Files);
   if(!inputDir.exists()) {
     printf("Input folder '\033[1;32m%s\033[0m' doesn't exist or can't be seen by current user. Please check path and permissions.\n", inputDir.absolutePath().toStdString().c_str());
+    if(batchMode) {
+      printf("Skipping platform '\033[1;32m%s\033[0m'\n\n", config.platform.toStdString().c_str());
+      return false;
+    }
     exit(1);
   }
 
@@ -98,39 +216,57 @@ void Skyscraper::run()
     config.videosFolder = videosDir.absolutePath();
   }
 
+  // In batch mode platforms sharing a db folder also share the db and the rom
+  // checksum cache in memory
+  QString dbAbsolutePath = QDir(config.dbFolder).absolutePath();
   if(!config.dbFolder.isEmpty() && config.localDb) {
-    localDb = QSharedPointer<LocalDb>(new LocalDb(config.dbFolder));
-    if(localDb->createFolders(config.scraper)) {
-      localDb->readDb();
+    if(localDbs.contains(dbAbsolutePath)) {
+      platformRun.localDb = localDbs.value(dbAbsolutePath);
+    } else {
+      platformRun.localDb = QSharedPointer<LocalDb>(new LocalDb(config.dbFolder, config.dbFormat));
+    }
+    if(platformRun.localDb->createFolders(config.scraper)) {
+      if(!localDbs.contains(dbAbsolutePath)) {
+	platformRun.localDb->readDb();
+	localDbs.insert(dbAbsolutePath, platformRun.localDb);
+      }
     } else {
       printf("Couldn't create local db folders, disabling localdb...\n");
       config.localDb = false;
     }
   }
-  if(config.localDb && config.cleanDb) {
-    localDb->cleanDb();
-    exit(0);
-  }
-  if(config.localDb && !config.mergeDb.isEmpty() && QDir(config.mergeDb).exists()) {
-    LocalDb srcDb(config.mergeDb);
-    srcDb.readDb();
-    localDb->mergeDb(srcDb, config.updateDb, config.mergeDb);
-    localDb->writeDb();
-    exit(0);
-  }
+  QSharedPointer<LocalDb> localDb = platformRun.localDb;
   if(config.localDb) {
     localDb->readPriorities();
+    if(hashCaches.contains(dbAbsolutePath)) {
+      platformRun.hashCache = hashCaches.value(dbAbsolutePath);
+    } else {
+      // With '--rehash' the cache starts out empty and is filled with fresh checksums
+      platformRun.hashCache = QSharedPointer<HashCache>(new HashCache(config.dbFolder));
+      if(!config.rehash) {
+	platformRun.hashCache->read();
+      }
+      hashCaches.insert(dbAbsolutePath, platformRun.hashCache);
+    }
   }
+  // ScreenScraper searches by rom checksums, the others only need the local db key
+  platformRun.romDigests = (config.scraper == "screenscraper");
   
-  gameListFileString = gameListDir.absolutePath() + "/" + frontend->getGameListFileName();
+  platformRun.gameListFileString = gameListDir.absolutePath() + "/" + frontend->getGameListFileName();
+  platformRun.journalFileString = gameListDir.absolutePath() + "/.skyscraper-journal-" + config.scraper;
+  platformRun.manifestFileString = gameListDir.absolutePath() + "/.skyscraper-manifest-" + config.scraper;
 
-  QFile gameListFile(gameListFileString);
+  QFile gameListFile(platformRun.gameListFileString);
 
   if(!config.pretend && !config.unattend && gameListFile.exists()) {
     std::string userInput = "";
     printf("\033[1;34m'\033[1;32m%s\033[0m\033[1;34m' already exists, do you want to overwrite it\033[0m (y/N)? ", frontend->getGameListFileName().toStdString().c_str());
     getline(std::cin, userInput);
     if(userInput != "y") {
+      if(batchMode) {
+	printf("User chose not to overwrite, skipping platform...\n\n");
+	return false;
+      }
       printf("User chose not to overwrite, now exiting...\n");
       exit(0);
     }
@@ -146,89 +282,435 @@ void Skyscraper::run()
     }
   }
   if(config.pretend) {
-    printf("Pretend set! Not changing any files except '%s'.\n\n", skippedFileString.toStdString().c_str());
+    printf("Pretend set! Not changing any files except '%s'.\n\n", platformRun.skippedFileString.toStdString().c_str());
   }
 
-  QFile skippedFile(skippedFileString);
+  QFile skippedFile(platformRun.skippedFileString);
   skippedFile.open(QIODevice::WriteOnly);
   skippedFile.write("--- The following is a list of skipped games ---\n");
   skippedFile.close();
 
-  QList<QFileInfo> inputFiles = inputDir.entryInfoList();
-  if(config.subDirs) {
-    QDirIterator dirIt(config.inputFolder,
-		       QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
-		       QDirIterator::Subdirectories);
-    while(dirIt.hasNext()) {
-      QString subdir = dirIt.next();
-      inputDir.setPath(subdir);
-      inputFiles.append(inputDir.entryInfoList());
-      if(config.verbose) {
-	printf("Added files from subdir: '%s'\n", subdir.toStdString().c_str());
-      }
+  // The state of each file as it was found is saved in the manifest after the run
+  inputFiles = getInputFiles(config, config.verbose);
+  foreach(QFileInfo info, inputFiles) {
+    platformRun.knownFiles.insert(info.absoluteFilePath(), fileState(info));
+  }
+  if(config.localDb) {
+    migrateNameKeys(platformRun, inputFiles);
+  }
+
+  // Finished entries are kept on disk until the gamelist is written. In watch mode
+  // entries are replaced when their files change
+  if(!platformRun.gameEntries.open(config.watch)) {
+    printf("Couldn't create temporary file for game entries, exiting...\n");
+    exit(1);
+  }
+
+  if(!config.pretend || config.incremental) {
+    platformRun.manifest = QSharedPointer<Manifest>(new Manifest(platformRun.manifestFileString));
+  }
+  if(config.incremental) {
+    if(platformRun.manifest->exists()) {
+      applyManifest(platformRun, inputFiles);
+    } else {
+      printf("No manifest from an earlier run found, scraping all files.\n\n");
     }
   }
 
-  if(!config.unattend) {
+  if(!config.unattend && !config.incremental) {
     std::string userInput = "";
     if(gameListFile.exists() && frontend->canSkip()) {
       printf("\033[1;34mDo you wish to skip existing entries\033[0m (y/N)? ");
       getline(std::cin, userInput);
       if(userInput == "y" && frontend->canSkip()) {
-	frontend->skipExisting(gameListFileString, gameEntries, inputFiles);
+	QList<GameEntry> existingEntries;
+	frontend->skipExisting(platformRun.gameListFileString, existingEntries, inputFiles);
+	foreach(GameEntry entry, existingEntries) {
+	  platformRun.gameEntries.addEntry(entry, frontend->getSortKey(entry));
+	}
       }
     }
   }
 
-  totalFiles = inputFiles.length();
+  // Every finished game is journaled, so an interrupted run can be resumed
+  if(!config.pretend) {
+    QSharedPointer<Journal> journal = QSharedPointer<Journal>(new Journal(platformRun.journalFileString));
+    platformRun.journal = journal;
+    if(config.resume) {
+      if(journal->exists()) {
+	resumeFromJournal(platformRun, inputFiles);
+      } else {
+	printf("No unfinished run found to resume, starting a new one.\n\n");
+      }
+    } else if(journal->exists()) {
+      printf("Discarding journal from an unfinished run. Use '--resume' to continue such a run instead.\n\n");
+      journal->remove();
+    }
+    if(!journal->open()) {
+      printf("\033[1;33mCouldn't open journal '%s', this run can't be resumed if interrupted.\033[0m\n\n", platformRun.journalFileString.toStdString().c_str());
+    }
+  }
+
+  return true;
+}
+
+// Cleans, exports or merges into the db of each platform. Platforms sharing a db
+// folder share the db, so each folder is only handled once. With several platforms
+// only the db folders that already exist are handled
+void Skyscraper::runDbOperations()
+{
+  QSet<QString> doneFolders;
+  foreach(QString platform, platforms) {
+    PlatformRun platformRun;
+    loadConfig(*parser, platform, platformRun);
+    const Settings &config = platformRun.config;
+    QString dbAbsolutePath = QDir(config.dbFolder).absolutePath();
+    if(!config.localDb || doneFolders.contains(dbAbsolutePath) ||
+       (batchMode && !QDir(dbAbsolutePath).exists())) {
+      continue;
+    }
+    doneFolders.insert(dbAbsolutePath);
+    printf("Local db folder : '\033[1;32m%s\033[0m'\n", dbAbsolutePath.toStdString().c_str());
+    LocalDb localDb(config.dbFolder, config.dbFormat);
+    if(!localDb.createFolders(config.scraper)) {
+      printf("Couldn't create local db folders, skipping this db...\n\n");
+      continue;
+    }
+    localDb.readDb();
+    if(config.cleanDb) {
+      localDb.cleanDb();
+    } else if(config.exportDb) {
+      printf("Exporting local db to '%s'...\n", (dbAbsolutePath + "/db.xml").toStdString().c_str());
+      localDb.exportDb();
+    } else if(!config.mergeDb.isEmpty() && QDir(config.mergeDb).exists()) {
+      // The db to merge from is read in whichever format it has
+      LocalDb srcDb(config.mergeDb, QFileInfo::exists(config.mergeDb + "/db.bin")?"binary":"xml");
+      srcDb.readDb();
+      localDb.mergeDb(srcDb, config.updateDb, config.mergeDb);
+      localDb.writeDb();
+    }
+    printf("\n");
+  }
+  if(doneFolders.isEmpty()) {
+    printf("No local db folders found for the chosen platforms.\n");
+  }
+}
+
+// Big files and cue sheets used to be keyed by their name. Their db entries are
+// moved to the new key once, when the db has been loaded, instead of the scraper
+// threads checking every file
+void Skyscraper::migrateNameKeys(PlatformRun &platformRun, const QList<QFileInfo> &inputFiles)
+{
+  QSharedPointer<LocalDb> localDb = platformRun.localDb;
+  int migrated = 0;
+  foreach(QFileInfo info, inputFiles) {
+    QString nameSha1 = HashStage::getNameSha1(info);
+    if(!localDb->hasSha1(nameSha1)) {
+      continue;
+    }
+    QString sha1 = HashStage::getFingerprintSha1(info);
+    if(sha1.isEmpty() || localDb->hasSha1(sha1)) {
+      continue;
+    }
+    localDb->rekeyResources(nameSha1, sha1);
+    migrated++;
+  }
+  if(migrated > 0) {
+    printf("Moved the local db entries of \033[1;32m%d\033[0m files from their name to a fingerprint of their data\n\n", migrated);
+  }
+}
+
+void Skyscraper::addJobs(QList<ScrapeJob> &jobs, const QList<QFileInfo> &inputFiles,
+			 QSharedPointer<PlatformRun> platformRun)
+{
+  foreach(QFileInfo info, inputFiles) {
+    ScrapeJob job;
+    job.info = info;
+    job.run = platformRun;
+    jobs.append(job);
+  }
+}
+
+// Starts the hashing, scraping and writing stages on the given files. Calls
+// checkThreads when all of them are done
+void Skyscraper::scrapeFiles(const QList<ScrapeJob> &jobs)
+{
+  // Hashing, writing and request settings only come from the main section or
+  // the command line, so they are the same for all platforms
+  const Settings &config = runs.first()->config;
+  threads = threadsSetting;
+  doneThreads = 0;
+  scraping = true;
+
+  foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+    platformRun->totalFiles = 0;
+    platformRun->scraped = 0;
+    // Copies of the same rom are only scraped once per run
+    platformRun->dupes = QSharedPointer<DupeTracker>(new DupeTracker());
+  }
+  foreach(const ScrapeJob &job, jobs) {
+    job.run->totalFiles++;
+  }
+
+  totalFiles = jobs.length();
   if(totalFiles == 0) {
     // A bit of a hack to let the scraping process take place. We want it to rewrite the gamelist
     printf("No entries to scrape...\n\n");
-    doneThreads = config.threads - 1;
+    doneThreads = threads - 1;
     checkThreads();
-    exit(0);
+    return;
   }
   
-  printf("\nStarting scraping run on \033[1;32m%d\033[0m files using \033[1;32m%d\033[0m threads.\nSit back, relax and let me do the work! :)\n\n", totalFiles, config.threads);
+  if(autoThreads) {
+    // Local runs are bound by cpu and disk, network runs mostly wait for replies
+    threads = QThread::idealThreadCount();
+    foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+      if(platformRun->config.scraper != "localdb" && platformRun->config.scraper != "import") {
+	threads = 32;
+	break;
+      }
+    }
+  }
 
-  timer.start();
-  currentFile = 1;
+  // Do not start more threads if we have less files than allowed threads
+  if(threads > totalFiles) {
+    threads = totalFiles;
+  }
 
-  int filesPerThread = (totalFiles - totalFiles % config.threads) / config.threads;
-  if(totalFiles < config.threads) {
-    filesPerThread = 1;
+  // In auto mode all threads are created, but only some of them are active at a time
+  int activeThreads = threads;
+  QString threadsString = QString::number(threads);
+  if(autoThreads) {
+    activeThreads = (threads < 2?threads:2);
+    threadsString = QString::number(activeThreads) + "-" + QString::number(threads) + " (auto)";
   }
-  
-  if(config.verbose) {
-    printf("Files per thread: %d\n", filesPerThread);
+
+  if(asyncThreads) {
+    printf("\nStarting scraping run on \033[1;32m%d\033[0m files asynchronously from one network thread with up to \033[1;32m%d\033[0m network requests in flight in total.\nSit back, relax and let me do the work! :)\n\n", totalFiles, config.inFlight);
+  } else {
+    printf("\nStarting scraping run on \033[1;32m%d\033[0m files using \033[1;32m%s\033[0m threads with up to \033[1;32m%d\033[0m network requests in flight in total.\nSit back, relax and let me do the work! :)\n\n", totalFiles, threadsString.toStdString().c_str(), config.inFlight);
   }
+
+  timer.start();
+  currentFile = 1;
+
+  // Requests in flight are limited for all scraper threads together
+  HostGovernor::setMaxInFlight(config.inFlight);
+
+  // Files are hashed, scraped and written to disk by separate pools of threads.
+  // The hashers pull their files from this shared queue one at a time
+  QSharedPointer<Queue> queue = QSharedPointer<Queue>(new Queue());
+  queue->append(jobs);
+
+  // The async worker keeps up to 'inFlight' files in progress, so it needs more
+  // files ready than a single thread would
+  scrapeQueue = QSharedPointer<ScrapeQueue>(new ScrapeQueue((asyncThreads?config.inFlight:threads) * 4));
+  scrapeQueue->setActiveWorkers(activeThreads);
+  hashStage = QSharedPointer<HashStage>(new HashStage(config.hashThreads));
+  writeStage = QSharedPointer<WriteStage>(new WriteStage(config.writeThreads));
+
   QList<QThread*> threadList;
-  for(int curThread = 1; curThread <= config.threads; ++curThread) {
-    int beginIdx = (curThread - 1) * filesPerThread;
-    if(curThread == config.threads) {
-      filesPerThread += totalFiles % config.threads;
-    }
+  for(int curThread = 1; curThread <= threads; ++curThread) {
     QThread *thread = new QThread;
-    ScraperWorker *worker = new ScraperWorker(inputFiles, filesPerThread, beginIdx, config, localDb);
+    ScraperWorker *worker;
+    if(asyncThreads) {
+      worker = new AsyncWorker(scrapeQueue, writeStage, config.inFlight);
+    } else {
+      worker = new ScraperWorker(scrapeQueue, writeStage, curThread - 1);
+    }
     worker->moveToThread(thread);
     connect(thread, &QThread::started, worker, &ScraperWorker::run);
     connect(worker, &ScraperWorker::outputToTerminal, this, &Skyscraper::outputToTerminal);
     connect(worker, &ScraperWorker::entryReady, this, &Skyscraper::entryReady);
     //connect(worker, &ScraperWorker::addToSkipped, this, &Skyscraper::addToSkipped);
     connect(worker, &ScraperWorker::allDone, this, &Skyscraper::checkThreads);
+    connect(worker, &ScraperWorker::allDone, thread, &QThread::quit);
     connect(thread, &QThread::finished, worker, &ScraperWorker::deleteLater);
     connect(thread, &QThread::finished, thread, &QThread::deleteLater);
     threadList.append(thread);
-    // Do not start more threads if we have less files than allowed threads
-    if(curThread == totalFiles) {
-      config.threads = curThread;
-      break;
-    }
   }
   // Ready, set, GO!!! Start all threads
+  hashStage->start(queue, scrapeQueue);
   foreach(QThread *thread, threadList) {
     thread->start();
   }
+  if(autoThreads) {
+    lastDone = 0;
+    lastThroughput = 0;
+    tuneTimer.start(3000);
+  }
+}
+
+// Called regularly in auto thread mode. Looks at how the stages around the scraper
+// threads are doing and adjusts the number of active threads accordingly
+void Skyscraper::tuneThreads()
+{
+  if(scrapeQueue.isNull() || writeStage.isNull()) {
+    return;
+  }
+  entryMutex.lock();
+  int done = currentFile - 1;
+  entryMutex.unlock();
+  int throughput = done - lastDone;
+  lastDone = done;
+
+  int activeThreads = scrapeQueue->getActiveWorkers();
+  qint64 interval = tuneTimer.interval();
+  qint64 waitMsecs = scrapeQueue->takeWaitMsecs();
+  qint64 blockedMsecs = writeStage->takeBlockedMsecs();
+  bool hostLimited = HostGovernor::takeLimited();
+
+  int newThreads = activeThreads;
+  if(blockedMsecs > interval * activeThreads / 4) {
+    // Compositing and writing can't keep up, more threads would just queue up there
+    newThreads--;
+  } else if(waitMsecs > interval * activeThreads / 4 || hostLimited) {
+    // Waiting for the hashing or for the host limits. More threads won't help
+  } else if(throughput >= lastThroughput) {
+    newThreads++;
+  } else if(throughput * 10 < lastThroughput * 9) {
+    // Last change made things worse
+    newThreads--;
+  }
+  if(newThreads < 1) {
+    newThreads = 1;
+  }
+  if(newThreads > threads) {
+    newThreads = threads;
+  }
+  lastThroughput = throughput;
+
+  if(newThreads != activeThreads) {
+    scrapeQueue->setActiveWorkers(newThreads);
+    if(runs.first()->config.verbose) {
+      printf("Adjusted number of active threads to \033[1;32m%d\033[0m\n\n", newThreads);
+    }
+  }
+}
+
+void Skyscraper::printLimits(const QString &name, const HostLimits &hostLimits)
+{
+  if(hostLimits.requestsPerSecond <= 0.0 && hostLimits.maxInFlight <= 0) {
+    return;
+  }
+  printf("Request limits for %s:", name.toStdString().c_str());
+  if(hostLimits.requestsPerSecond > 0.0) {
+    printf(" \033[1;32m%.2f\033[0m per second", hostLimits.requestsPerSecond);
+  }
+  if(hostLimits.maxInFlight > 0) {
+    printf(" \033[1;32m%d\033[0m at a time", hostLimits.maxInFlight);
+  }
+  printf("\n");
+}
+
+QList<QFileInfo> Skyscraper::getInputFiles(const Settings &config, bool verbose)
+{
+  QDir inputDir(config.inputFolder, Platform::getFormats(config.platform), QDir::Name, QDir::Files);
+  QList<QFileInfo> inputFiles = inputDir.entryInfoList();
+  if(config.subDirs) {
+    QDirIterator dirIt(config.inputFolder,
+		       QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+		       QDirIterator::Subdirectories);
+    while(dirIt.hasNext()) {
+      QString subdir = dirIt.next();
+      inputDir.setPath(subdir);
+      inputFiles.append(inputDir.entryInfoList());
+      if(verbose) {
+	printf("Added files from subdir: '%s'\n", subdir.toStdString().c_str());
+      }
+    }
+  }
+  return inputFiles;
+}
+
+QString Skyscraper::fileState(const QFileInfo &info)
+{
+  return QString::number(info.size()) + ":" + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+// Watches the input folders after the first run. Changes are collected for a
+// couple of seconds before anything is scraped, so a batch of roms being copied
+// in is handled in one go
+void Skyscraper::startWatching()
+{
+  const Settings &config = runs.first()->config;
+  if(!watcher.directories().isEmpty()) {
+    watcher.removePaths(watcher.directories());
+  }
+  QStringList folders(config.inputFolder);
+  if(config.subDirs) {
+    QDirIterator dirIt(config.inputFolder,
+		       QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+		       QDirIterator::Subdirectories);
+    while(dirIt.hasNext()) {
+      folders.append(dirIt.next());
+    }
+  }
+  watcher.addPaths(folders);
+}
+
+void Skyscraper::inputChanged()
+{
+  // Restart the timer on every change, so we only rescan once things settle down
+  watchTimer.start();
+}
+
+void Skyscraper::rescanInput()
+{
+  if(scraping) {
+    // Rescan once the current run is done
+    rescanPending = true;
+    return;
+  }
+  rescanPending = false;
+
+  // Watch mode only takes a single platform
+  QSharedPointer<PlatformRun> platformRun = runs.first();
+  QMap<QString, QString> &knownFiles = platformRun->knownFiles;
+  QList<QFileInfo> changedFiles;
+  QMap<QString, QString> currentFiles;
+  foreach(QFileInfo info, getInputFiles(platformRun->config, false)) {
+    QString path = info.absoluteFilePath();
+    currentFiles.insert(path, fileState(info));
+    if(knownFiles.value(path) != currentFiles.value(path)) {
+      changedFiles.append(info);
+      // The old entry of a changed file goes, whether or not the file is found again
+      if(knownFiles.contains(path)) {
+	platformRun->gameEntries.removeEntry(path);
+	platformRun->skippedEntries.remove(path);
+      }
+    }
+  }
+  int removed = 0;
+  foreach(QString path, knownFiles.keys()) {
+    if(!currentFiles.contains(path)) {
+      platformRun->gameEntries.removeEntry(path);
+      platformRun->skippedEntries.remove(path);
+      removed++;
+    }
+  }
+  knownFiles = currentFiles;
+
+  if(changedFiles.isEmpty() && removed == 0) {
+    return;
+  }
+  // New subfolders need to be watched as well
+  startWatching();
+  printf("\033[1;34m---- Found %d new or changed and %d removed files ----\033[0m\n", changedFiles.length(), removed);
+
+  // The journal was removed when the last gamelist was written. Start a new one
+  // so this rescan can be resumed as well
+  if(!platformRun->journal.isNull() && !platformRun->journal->open()) {
+    printf("\033[1;33mCouldn't open journal '%s', this run can't be resumed if interrupted.\033[0m\n\n", platformRun->journalFileString.toStdString().c_str());
+  }
+
+  platformRun->notFound = 0;
+  platformRun->found = 0;
+  platformRun->avgCompleteness = 0;
+  platformRun->avgSearchMatch = 0;
+  QList<ScrapeJob> jobs;
+  addJobs(jobs, changedFiles, platformRun);
+  scrapeFiles(jobs);
 }
 
 void Skyscraper::checkForFolder(QDir &folder)
@@ -276,42 +758,60 @@ QString Skyscraper::secsToString(const int &secs)
   return hours + ":" + minutes + ":" + seconds;
 }
 
-void Skyscraper::entryReady(const GameEntry &entry)
+void Skyscraper::entryReady(const GameEntry &entry, int platformIndex)
 {
   entryMutex.lock();
 
+  PlatformRun &platformRun = *runs.at(platformIndex);
+  // Entries that were already underway when their platform was given up on
+  if(platformRun.abandoned) {
+    entryMutex.unlock();
+    return;
+  }
+  const Settings &config = platformRun.config;
+  QSharedPointer<AbstractFrontend> frontend = platformRun.frontend;
+  EntrySpool &gameEntries = platformRun.gameEntries;
   GameEntry tmpEntry = entry;
+  platformRun.scraped++;
 
   if(tmpEntry.found) {
-    found++;
-    avgCompleteness += tmpEntry.completeness(config.videos);
-    avgSearchMatch += tmpEntry.searchMatch;
+    platformRun.found++;
+    platformRun.avgCompleteness += tmpEntry.completeness(config.videos);
+    platformRun.avgSearchMatch += tmpEntry.searchMatch;
     // Remove unnecessary media data to save memory before adding it to final entrylist
     // At this point data has been saved to disc, so we don't need it anymore.
     tmpEntry.coverData = QImage();
     tmpEntry.screenshotData = QImage();
     tmpEntry.videoData = "";
-    gameEntries.append(tmpEntry);
+    gameEntries.addEntry(tmpEntry, frontend->getSortKey(tmpEntry));
+    platformRun.skippedEntries.remove(tmpEntry.path);
   } else {
-    notFound++;
-    QFile skippedFile(skippedFileString);
-    skippedFile.open(QIODevice::Append);
-    skippedFile.write("'" + tmpEntry.baseName.toUtf8() + "'");
-    if(tmpEntry.searchMatch == 0) {
-      skippedFile.write(", No returned matches\n");
+    platformRun.notFound++;
+    addToSkippedFile(platformRun, tmpEntry);
+    if(config.skipped) {
+      gameEntries.addEntry(tmpEntry, frontend->getSortKey(tmpEntry));
     } else {
-      skippedFile.write(", Closest match was '" + tmpEntry.title.toUtf8() + "'\n");
+      // Drops the entry of a file that was found before it changed
+      gameEntries.removeEntry(tmpEntry.path);
     }
-    skippedFile.close();
-    if(config.skipped) {
-      gameEntries.append(tmpEntry);
+    // Games that weren't found are only in the gamelist with '--skipped', but they
+    // go in the manifest either way
+    if(!platformRun.manifest.isNull()) {
+      platformRun.skippedEntries.insert(tmpEntry.path, tmpEntry);
     }
   }
   
-  if(currentFile == 30 && notFound == 30 &&
+  if(platformRun.found == 0 && platformRun.notFound == 30 &&
      config.scraper != "import" && config.scraper != "localdb") {
-    printf("\033[1;31mThis is NOT going well! I guit! *slams the door*\nNo, seriously, out of 30 files we had 30 misses, which probably means you are using a scraping source that doesn't support this platform. Please be considerate and choose a scraping module that supports the platform you are scraping (check '--help').\n\nNow exiting...\033[0m\n");
-    exit(1);
+    if(!batchMode) {
+      printf("\033[1;31mThis is NOT going well! I guit! *slams the door*\nNo, seriously, out of 30 files we had 30 misses, which probably means you are using a scraping source that doesn't support this platform. Please be considerate and choose a scraping module that supports the platform you are scraping (check '--help').\n\nNow exiting...\033[0m\n");
+      exit(1);
+    }
+    // The other platforms of the batch still get their gamelists and db updates
+    printf("\033[1;31mThis is NOT going well for platform '%s'! Out of 30 files we had 30 misses, which probably means '%s' doesn't support this platform. Please be considerate and choose a scraping module that supports the platform you are scraping (check '--help').\n\nSkipping the rest of this platform...\033[0m\n\n", config.platform.toStdString().c_str(), config.scraper.toStdString().c_str());
+    platformRun.abandoned = true;
+    scrapeQueue->abandonRun(&platformRun);
+    totalFiles -= platformRun.totalFiles - platformRun.scraped;
   }
 
   currentFile++;
@@ -319,54 +819,243 @@ void Skyscraper::entryReady(const GameEntry &entry)
   entryMutex.unlock();
 }
 
+void Skyscraper::addToSkippedFile(const PlatformRun &platformRun, const GameEntry &entry)
+{
+  QFile skippedFile(platformRun.skippedFileString);
+  skippedFile.open(QIODevice::Append);
+  skippedFile.write("'" + entry.baseName.toUtf8() + "'");
+  if(entry.searchMatch == 0) {
+    skippedFile.write(", No returned matches\n");
+  } else {
+    skippedFile.write(", Closest match was '" + entry.title.toUtf8() + "'\n");
+  }
+  skippedFile.close();
+}
+
+// Adds the games from the journal of an interrupted run and removes their files
+// from the list of files to scrape
+void Skyscraper::resumeFromJournal(PlatformRun &platformRun, QList<QFileInfo> &inputFiles)
+{
+  const Settings &config = platformRun.config;
+  QSharedPointer<AbstractFrontend> frontend = platformRun.frontend;
+  QSet<QString> remaining;
+  foreach(QFileInfo info, inputFiles) {
+    remaining.insert(info.absoluteFilePath());
+  }
+
+  QSet<QString> done;
+  foreach(JournalRecord record, platformRun.journal->readRecords()) {
+    GameEntry &entry = record.entry;
+    if(!remaining.contains(entry.path) || done.contains(entry.path)) {
+      continue;
+    }
+    done.insert(entry.path);
+    if(config.localDb && !record.resources.isEmpty()) {
+      platformRun.localDb->restoreResources(record.resources);
+    }
+    if(entry.found) {
+      platformRun.found++;
+      platformRun.avgCompleteness += record.completeness;
+      platformRun.avgSearchMatch += entry.searchMatch;
+      platformRun.gameEntries.addEntry(entry, frontend->getSortKey(entry));
+    } else {
+      platformRun.notFound++;
+      addToSkippedFile(platformRun, entry);
+      if(config.skipped) {
+	platformRun.gameEntries.addEntry(entry, frontend->getSortKey(entry));
+      }
+      if(!platformRun.manifest.isNull()) {
+	platformRun.skippedEntries.insert(entry.path, entry);
+      }
+    }
+  }
+
+  for(int a = inputFiles.length() - 1; a >= 0; --a) {
+    if(done.contains(inputFiles.at(a).absoluteFilePath())) {
+      inputFiles.removeAt(a);
+    }
+  }
+  printf("Resuming unfinished run, \033[1;32m%d\033[0m games were already done.\n\n", done.count());
+}
+
+// Adds the games of files that haven't changed since the last completed run and
+// removes those files from the list of files to scrape. The games of files that
+// are gone are handed to the scraper threads, which reuse them for new files with
+// the same local db key
+void Skyscraper::applyManifest(PlatformRun &platformRun, QList<QFileInfo> &inputFiles)
+{
+  QSharedPointer<Manifest> manifest = platformRun.manifest;
+  const QMap<QString, QString> &knownFiles = platformRun.knownFiles;
+  if(!manifest->rewind()) {
+    printf("\033[1;33mCouldn't read manifest '%s', scraping all files.\033[0m\n\n", platformRun.manifestFileString.toStdString().c_str());
+    return;
+  }
+  QSet<QString> done;
+  int missing = 0;
+  ManifestRecord record;
+  while(manifest->nextRecord(record)) {
+    GameEntry &entry = record.entry;
+    if(!knownFiles.contains(entry.path)) {
+      if(!entry.sha1.isEmpty()) {
+	manifest->addMissing(entry);
+	missing++;
+      }
+      continue;
+    }
+    if(knownFiles.value(entry.path) != record.state || done.contains(entry.path)) {
+      continue;
+    }
+    done.insert(entry.path);
+    if(entry.found || platformRun.config.skipped) {
+      platformRun.gameEntries.addEntry(entry, platformRun.frontend->getSortKey(entry));
+    }
+    if(!entry.found) {
+      platformRun.skippedEntries.insert(entry.path, entry);
+    }
+  }
+
+  for(int a = inputFiles.length() - 1; a >= 0; --a) {
+    if(done.contains(inputFiles.at(a).absoluteFilePath())) {
+      inputFiles.removeAt(a);
+    }
+  }
+  printf("Incremental run, \033[1;32m%d\033[0m files are unchanged since the last run and \033[1;32m%d\033[0m are new or changed.\n", done.count(), inputFiles.length());
+  if(missing > 0) {
+    printf("\033[1;32m%d\033[0m files from the last run are gone. Their games are dropped unless the files have been renamed.\n", missing);
+  }
+  printf("\n");
+}
+
+// Saves the state and gamelist entry of every file of the run for '--incremental'
+void Skyscraper::writeManifest(PlatformRun &platformRun)
+{
+  QSharedPointer<Manifest> manifest = platformRun.manifest;
+  const QMap<QString, QString> &knownFiles = platformRun.knownFiles;
+  if(!manifest->open()) {
+    printf("\033[1;33mCouldn't write manifest '%s', next incremental run will scrape all files.\033[0m\n\n", platformRun.manifestFileString.toStdString().c_str());
+    return;
+  }
+  platformRun.gameEntries.rewind();
+  GameEntry entry;
+  while(platformRun.gameEntries.nextEntry(entry)) {
+    if(entry.found) {
+      manifest->addRecord(knownFiles.value(entry.path), entry);
+    }
+  }
+  foreach(GameEntry skippedEntry, platformRun.skippedEntries) {
+    manifest->addRecord(knownFiles.value(skippedEntry.path), skippedEntry);
+  }
+  if(!manifest->commit()) {
+    printf("\033[1;33mCouldn't write manifest '%s', next incremental run will scrape all files.\033[0m\n\n", platformRun.manifestFileString.toStdString().c_str());
+  }
+}
+
 void Skyscraper::checkThreads()
 {
   checkThreadMutex.lock();
 
   doneThreads++;
-  if(doneThreads == config.threads) {
+  if(doneThreads == threads) {
+    tuneTimer.stop();
     printf("\033[1;34m---- Scraping run completed! YAY! ----\033[0m\n");
-    if(!config.pretend && !config.dbFolder.isEmpty() && config.localDb) {
-      localDb->writeDb();
+    // Make sure all media and resources have been written before saving the db
+    if(!writeStage.isNull()) {
+      writeStage->waitForDone();
     }
-
-    frontend->sortEntries(gameEntries);
-
-    QString finalOutput;
-    frontend->assembleList(finalOutput, gameEntries, config.maxLength);
-    
-    if(!config.pretend) {
-      QFile gameListFile(gameListFileString);
-      printf("Now writing '%s'... ", gameListFileString.toStdString().c_str());
-      if(gameListFile.open(QIODevice::WriteOnly)) {
-	gameListFile.write(finalOutput.toUtf8());
-	gameListFile.close();
-	printf("\033[1;32mSuccess!!!\033[0m\n\n");
-      } else {
-	printf("\033[1;31mCouldn't open file for writing!!!\nAll that work for nothing... :(\033[0m\n");
+    // Platforms sharing a db folder share the db and checksum cache, so they are
+    // only written once
+    QSet<LocalDb*> writtenDbs;
+    QSet<HashCache*> writtenCaches;
+    foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+      const Settings &config = platformRun->config;
+      if(config.pretend) {
+	continue;
+      }
+      if(!config.dbFolder.isEmpty() && config.localDb &&
+	 !writtenDbs.contains(platformRun->localDb.data())) {
+	platformRun->localDb->writeDb();
+	writtenDbs.insert(platformRun->localDb.data());
+      }
+      if(!platformRun->hashCache.isNull() &&
+	 !writtenCaches.contains(platformRun->hashCache.data())) {
+	if(!platformRun->hashCache->write()) {
+	  printf("\033[1;33mCouldn't write rom checksum cache, files will be hashed again next time\033[0m\n");
+	}
+	writtenCaches.insert(platformRun->hashCache.data());
       }
     }
 
-    printf("\033[1;34m---- And here are some neat stats :) ----\033[0m\n");
-    printf("Total completion time: \033[1;33m%s\033[0m\n\n", secsToString(timer.elapsed()).toStdString().c_str());
-    if(found > 0) {
-      printf("Average search match: \033[1;33m%d%%\033[0m\n",
-	     (int)((double)avgSearchMatch / (double)found));
-      printf("Average entry completeness: \033[1;33m%d%%\033[0m\n\n",
-	     (int)((double)avgCompleteness / (double)found));
+    foreach(QSharedPointer<PlatformRun> platformRun, runs) {
+      if(platformRun->abandoned) {
+	printf("\033[1;33mPlatform '%s' was skipped, its gamelist is left as it was.\033[0m\n\n", platformRun->config.platform.toStdString().c_str());
+	continue;
+      }
+      finishRun(*platformRun);
     }
-    printf("\033[1;34mTotal number of games: %d\033[0m\n", totalFiles);
-    printf("\033[1;32mSuccessfully scraped games: %d\033[0m\n", found);
-    printf("\033[1;33mSkipped games: %d (Filenames saved to '%s')\033[0m\n\n", notFound, skippedFileString.toStdString().c_str());
+    printf("Total completion time: \033[1;33m%s\033[0m\n\n", secsToString(timer.elapsed()).toStdString().c_str());
 
-    // All done, now clean up and exit to terminal
-    emit finished();
+    scraping = false;
+    if(runs.first()->config.watch) {
+      if(watcher.directories().isEmpty()) {
+	startWatching();
+      }
+      printf("\033[1;34mWatching '%s' for new or changed files, press Ctrl+C to quit...\033[0m\n\n", runs.first()->config.inputFolder.toStdString().c_str());
+      if(rescanPending) {
+	watchTimer.start();
+      }
+    } else {
+      // All done, exit to terminal
+      emit finished();
+    }
   }
 
   checkThreadMutex.unlock();
 }
 
-void Skyscraper::loadConfig(const QCommandLineParser &parser)
+// Writes the gamelist and manifest of a platform and prints its stats
+void Skyscraper::finishRun(PlatformRun &platformRun)
+{
+  const Settings &config = platformRun.config;
+  if(!config.pretend) {
+    // Entries are streamed to the gamelist in sorted order. The existing gamelist
+    // is only replaced once the new one has been completely written
+    QSaveFile gameListFile(platformRun.gameListFileString);
+    printf("Now writing '%s'... ", platformRun.gameListFileString.toStdString().c_str());
+    if(gameListFile.open(QIODevice::WriteOnly)) {
+      platformRun.frontend->assembleList(gameListFile, platformRun.gameEntries, config.maxLength);
+    }
+    if(gameListFile.commit()) {
+      printf("\033[1;32mSuccess!!!\033[0m\n\n");
+      // Run is complete, so there's nothing left to resume
+      if(!platformRun.journal.isNull()) {
+	platformRun.journal->remove();
+      }
+      writeManifest(platformRun);
+    } else {
+      printf("\033[1;31mCouldn't write file!!!\nAll that work for nothing... :(\033[0m\n");
+    }
+  }
+
+  printf("\033[1;34m---- And here are some neat stats :) ----\033[0m\n");
+  if(batchMode) {
+    printf("Platform: '\033[1;32m%s\033[0m'\n\n", config.platform.toStdString().c_str());
+  }
+  if(platformRun.found > 0) {
+    printf("Average search match: \033[1;33m%d%%\033[0m\n",
+	   (int)((double)platformRun.avgSearchMatch / (double)platformRun.found));
+    printf("Average entry completeness: \033[1;33m%d%%\033[0m\n\n",
+	   (int)((double)platformRun.avgCompleteness / (double)platformRun.found));
+  }
+  printf("\033[1;34mTotal number of games: %d\033[0m\n", platformRun.totalFiles);
+  printf("\033[1;32mSuccessfully scraped games: %d\033[0m\n", platformRun.found);
+  printf("\033[1;33mSkipped games: %d (Filenames saved to '%s')\033[0m\n", platformRun.notFound, platformRun.skippedFileString.toStdString().c_str());
+  if(config.incremental && !platformRun.manifest.isNull() && platformRun.manifest->missingCount() > 0) {
+    printf("\033[1;33mDropped games of removed files: %d\033[0m\n", platformRun.manifest->missingCount());
+  }
+  printf("\n");
+}
+
+void Skyscraper::installFiles()
 {
   if(!QFileInfo::exists("config.ini")) {
     QFile::copy("/usr/local/etc/skyscraper/config.ini.example", "config.ini");
@@ -416,7 +1105,12 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     QFile::remove("import/definitions.dat.example2");
   }
   QFile::copy("/usr/local/etc/skyscraper/import/definitions.dat.example2", "import/definitions.dat.example2");
+}
 
+void Skyscraper::loadConfig(const QCommandLineParser &parser, const QString &platform,
+			    PlatformRun &platformRun)
+{
+  Settings &config = platformRun.config;
   QSettings settings(parser.isSet("c")?parser.value("c"):"config.ini", QSettings::IniFormat);
 
   // Artwork config
@@ -495,13 +1189,15 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
 			   parser.value("f") == "attractmode")) {
     config.frontend = parser.value("f");
   }
+  QSharedPointer<AbstractFrontend> frontend;
   if(config.frontend == "emulationstation") {
-    frontend = new EmulationStation;
+    frontend = QSharedPointer<AbstractFrontend>(new EmulationStation);
   } else if(config.frontend == "attractmode") {
-    frontend = new AttractMode;
+    frontend = QSharedPointer<AbstractFrontend>(new AttractMode);
   }
 
   frontend->setConfig(&config);
+  platformRun.frontend = frontend;
   
   bool inputFolderSet = false;
   bool gameListFolderSet = false;
@@ -532,7 +1228,26 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.maxLength = settings.value("maxLength").toInt();
   }
   if(settings.contains("threads")) {
-    config.threads = settings.value("threads").toInt();
+    if(settings.value("threads").toString() == "auto") {
+      config.autoThreads = true;
+      config.asyncThreads = false;
+    } else if(settings.value("threads").toString() == "async") {
+      config.asyncThreads = true;
+      config.autoThreads = false;
+    } else {
+      config.threads = settings.value("threads").toInt();
+      config.autoThreads = false;
+      config.asyncThreads = false;
+    }
+  }
+  if(settings.contains("hashThreads")) {
+    config.hashThreads = settings.value("hashThreads").toInt();
+  }
+  if(settings.contains("writeThreads")) {
+    config.writeThreads = settings.value("writeThreads").toInt();
+  }
+  if(settings.contains("inFlight")) {
+    config.inFlight = settings.value("inFlight").toInt();
   }
   if(settings.contains("emulator")) {
     config.emulator = settings.value("emulator").toString();
@@ -546,15 +1261,13 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(settings.contains("brackets")) {
     config.brackets = !settings.value("brackets").toBool();
   }
+  if(settings.contains("dbFormat")) {
+    config.dbFormat = settings.value("dbFormat").toString();
+  }
   settings.endGroup();
 
-  // Check for command line platform here, since we need it for 'platform' config.ini entries
-  if(parser.isSet("p") && Platform::getPlatforms().contains(parser.value("p"))) {
-    config.platform = parser.value("p");
-  } else {
-    printf("Please set a valid platform with '-p [platform]'\nCheck '--help' for a list of supported platforms, now exiting...\n");
-    exit(1);
-  }
+  // Platform comes from the command line, we need it for 'platform' config.ini entries
+  config.platform = platform;
 
   // Platform specific config, overrides main and defaults
   settings.beginGroup(config.platform);
@@ -600,7 +1313,17 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.userCreds = settings.value("userCreds").toString();
   }
   if(settings.contains("threads")) {
-    config.threads = settings.value("threads").toInt();
+    if(settings.value("threads").toString() == "auto") {
+      config.autoThreads = true;
+      config.asyncThreads = false;
+    } else if(settings.value("threads").toString() == "async") {
+      config.asyncThreads = true;
+      config.autoThreads = false;
+    } else {
+      config.threads = settings.value("threads").toInt();
+      config.autoThreads = false;
+      config.asyncThreads = false;
+    }
   }
   if(settings.contains("pretend")) {
     config.pretend = settings.value("pretend").toBool();
@@ -620,8 +1343,24 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(parser.isSet("l") && parser.value("l").toInt() >= 0 && parser.value("l").toInt() <= 10000) {
     config.maxLength = parser.value("l").toInt();
   }
-  if(parser.isSet("t") && parser.value("t").toInt() <= 8) {
-    config.threads = parser.value("t").toInt();
+  if(parser.isSet("t")) {
+    if(parser.value("t") == "auto") {
+      config.autoThreads = true;
+      config.asyncThreads = false;
+    } else if(parser.value("t") == "async") {
+      config.asyncThreads = true;
+      config.autoThreads = false;
+    } else if(parser.value("t").toInt() >= 1 && parser.value("t").toInt() <= 64) {
+      config.threads = parser.value("t").toInt();
+      config.autoThreads = false;
+      config.asyncThreads = false;
+    }
+  }
+  // Thread counts from config.ini are kept within the range '-t' allows
+  config.threads = qBound(1, config.threads, 64);
+  if(parser.isSet("inflight") && parser.value("inflight").toInt() >= 1 &&
+     parser.value("inflight").toInt() <= 256) {
+    config.inFlight = parser.value("inflight").toInt();
   }
   if(parser.isSet("e")) {
     config.emulator = parser.value("e");
@@ -654,6 +1393,30 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
 			   parser.value("s") == "import")) {
     config.scraper = parser.value("s");
   }
+
+  // Scraper specific limits, shared by all threads. They apply to the host the
+  // scraping module talks to. Other hosts, such as the one serving the media, can
+  // be limited with 'hosts/[host]/requestsPerSecond' and 'hosts/[host]/maxInFlight'
+  if(config.scraper == "arcadedb") {
+    // ArcadeDB only allows one request at a time
+    config.requestLimits.maxInFlight = 1;
+  }
+  settings.beginGroup(config.scraper);
+  if(settings.contains("requestsPerSecond")) {
+    config.requestLimits.requestsPerSecond = settings.value("requestsPerSecond").toDouble();
+  }
+  if(settings.contains("maxInFlight")) {
+    config.requestLimits.maxInFlight = settings.value("maxInFlight").toInt();
+  }
+  settings.beginGroup("hosts");
+  foreach(QString host, settings.childGroups()) {
+    HostLimits hostLimits;
+    hostLimits.requestsPerSecond = settings.value(host + "/requestsPerSecond").toDouble();
+    hostLimits.maxInFlight = settings.value(host + "/maxInFlight").toInt();
+    config.hostLimits.insert(host, hostLimits);
+  }
+  settings.endGroup();
+  settings.endGroup();
   if(parser.isSet("u") && parser.value("u").indexOf(":") != -1) {
     config.userCreds = parser.value("u");
   }
@@ -681,6 +1444,9 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(parser.isSet("cleandb")) {
     config.cleanDb = true;
   }
+  if(parser.isSet("exportdb")) {
+    config.exportDb = true;
+  }
   if(parser.isSet("mergedb") && QDir(config.mergeDb).exists()) {
     config.mergeDb = parser.value("mergedb");
   }
@@ -696,6 +1462,18 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(parser.isSet("unattend")) {
     config.unattend = true;
   }
+  if(parser.isSet("resume")) {
+    config.resume = true;
+  }
+  if(parser.isSet("incremental")) {
+    config.incremental = true;
+  }
+  if(parser.isSet("watch")) {
+    config.watch = true;
+  }
+  if(parser.isSet("rehash")) {
+    config.rehash = true;
+  }
   if(parser.isSet("region")) {
     config.region = parser.value("region");
   }
@@ -730,7 +1508,12 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.scraper = Platform::getDefaultScraper(config.platform);
   }
 
-  skippedFileString = "skipped-" + config.scraper + ".txt";
+  // Platforms of a batch get a list each, even if they use the same scraper
+  if(batchMode) {
+    platformRun.skippedFileString = "skipped-" + config.platform + "-" + config.scraper + ".txt";
+  } else {
+    platformRun.skippedFileString = "skipped-" + config.scraper + ".txt";
+  }
 }
 
 // --- Console colors ---
@@ -30,14 +30,24 @@
 #include <QFile>
 #include <QTime>
 #include <QMutex>
+#include <QTimer>
+#include <QFileSystemWatcher>
 #include <QCommandLineParser>
 
 #include "netcomm.h"
 #include "scraperworker.h"
+#include "asyncworker.h"
 #include "localdb.h"
 #include "abstractfrontend.h"
 #include "settings.h"
 #include "platform.h"
+#include "queue.h"
+#include "hashstage.h"
+#include "writestage.h"
+#include "hostgovernor.h"
+#include "journal.h"
+#include "manifest.h"
+#include "platformrun.h"
 
 class Skyscraper : public QObject
 {
@@ -54,34 +64,64 @@ signals:
   void finished();
 
 private slots:
-  void entryReady(const GameEntry &entry);
+  void entryReady(const GameEntry &entry, int platformIndex);
   void outputToTerminal(const QString &output);
   //void addToSkipped(const QString &gameBaseName, const QString &closestMatch);
   void checkThreads();
+  void tuneThreads();
+  void inputChanged();
+  void rescanInput();
   
 private:
-  Settings config;
-  void loadConfig(const QCommandLineParser &parser);
+  void installFiles();
+  void loadConfig(const QCommandLineParser &parser, const QString &platform,
+		  PlatformRun &platformRun);
+  bool prepareRun(PlatformRun &platformRun, QList<QFileInfo> &inputFiles);
+  void finishRun(PlatformRun &platformRun);
   QString secsToString(const int &seconds);
   void checkForFolder(QDir &folder);
+  void addToSkippedFile(const PlatformRun &platformRun, const GameEntry &entry);
+  void resumeFromJournal(PlatformRun &platformRun, QList<QFileInfo> &inputFiles);
+  void applyManifest(PlatformRun &platformRun, QList<QFileInfo> &inputFiles);
+  void writeManifest(PlatformRun &platformRun);
+  void runDbOperations();
+  void migrateNameKeys(PlatformRun &platformRun, const QList<QFileInfo> &inputFiles);
+  void addJobs(QList<ScrapeJob> &jobs, const QList<QFileInfo> &inputFiles,
+	       QSharedPointer<PlatformRun> platformRun);
+  void scrapeFiles(const QList<ScrapeJob> &jobs);
+  QList<QFileInfo> getInputFiles(const Settings &config, bool verbose);
+  QString fileState(const QFileInfo &info);
+  void printLimits(const QString &name, const HostLimits &hostLimits);
+  void startWatching();
 
-  AbstractFrontend *frontend;
+  const QCommandLineParser *parser;
+  QStringList platforms;
+  bool batchMode;
 
-  QSharedPointer<LocalDb> localDb;
+  QList<QSharedPointer<PlatformRun> > runs;
+  QMap<QString, QSharedPointer<LocalDb> > localDbs;
+  QMap<QString, QSharedPointer<HashCache> > hashCaches;
+  QSharedPointer<ScrapeQueue> scrapeQueue;
+  QSharedPointer<HashStage> hashStage;
+  QSharedPointer<WriteStage> writeStage;
   
-  QList<GameEntry> gameEntries;
   QMutex entryMutex;
   //QMutex skippedMutex;
   QMutex outputMutex;
   QMutex checkThreadMutex;
   QTime timer;
-  QString gameListFileString;
-  QString skippedFileString;
+  QTimer tuneTimer;
+  int lastDone;
+  int lastThroughput;
+  int threadsSetting;
+  int threads;
+  bool autoThreads;
+  bool asyncThreads;
+  QFileSystemWatcher watcher;
+  QTimer watchTimer;
+  bool scraping;
+  bool rescanPending;
   int doneThreads;
-  int notFound;
-  int found;
-  int avgSearchMatch;
-  int avgCompleteness;
   int currentFile;
   int totalFiles;
 };
@@ -126,6 +126,7 @@ void TheGamesDb::getGameData(GameEntry &game)
       ;
     }
   }
+  runFetchPlan(game);
 }
 
 void TheGamesDb::getRating(GameEntry &game)
@@ -235,34 +236,24 @@ void TheGamesDb::getTags(GameEntry &game)
   game.tags = game.tags.left(game.tags.length() - 2);
 }
 
-void TheGamesDb::getCover(GameEntry &game)
+void TheGamesDb::getCover(GameEntry &)
 {
   QDomNodeList xmlImages = xmlGame.firstChildElement("Images").elementsByTagName("boxart");
   for(int a = 0; a < xmlImages.count(); ++a) {
     if(xmlImages.at(a).toElement().attribute("side") == "front") {
       QString coverUrl = baseUrl + "/banners/" + xmlImages.at(a).toElement().text();
-      manager.request(coverUrl);
-      q.exec();
-      QImage image(QImage::fromData(manager.getData()));
-      if(!image.isNull()) {
-	game.coverData = image;
-      }
+      addToFetchPlan(COVER, coverUrl);
       break;
     }
   }
 }
 
-void TheGamesDb::getScreenshot(GameEntry &game)
+void TheGamesDb::getScreenshot(GameEntry &)
 {
   QDomNodeList xmlScreenshots =
     xmlGame.firstChildElement("Images").elementsByTagName("screenshot");
   if(!xmlScreenshots.isEmpty()) {
     QString screenshotUrl = baseUrl + "/banners/" + xmlScreenshots.at(0).firstChildElement("original").text();
-    manager.request(screenshotUrl);
-    q.exec();
-    QImage image(QImage::fromData(manager.getData()));
-    if(!image.isNull()) {
-      game.screenshotData = image;
-    }
+    addToFetchPlan(SCREENSHOT, screenshotUrl);
   }
 }
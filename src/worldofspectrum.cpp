@@ -124,7 +124,7 @@ void WorldOfSpectrum::getDescription(GameEntry &game)
   }
 }
 
-void WorldOfSpectrum::getCover(GameEntry &game)
+void WorldOfSpectrum::getCover(GameEntry &)
 {
   foreach(QString nom, coverPre) {
     nomNom(nom);
@@ -135,18 +135,13 @@ void WorldOfSpectrum::getCover(GameEntry &game)
   nomNom("<A HREF=\"");
   QString coverUrl = data.left(data.indexOf(coverPost));
   if(coverUrl.indexOf("http") != -1) {
-    manager.request(coverUrl);
+    addToFetchPlan(COVER, coverUrl);
   } else {
-    manager.request(baseUrl + (coverUrl.left(1) == "/"?"":"/") + coverUrl);
-  }
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.coverData = image;
+    addToFetchPlan(COVER, baseUrl + (coverUrl.left(1) == "/"?"":"/") + coverUrl);
   }
 }
 
-void WorldOfSpectrum::getScreenshot(GameEntry &game)
+void WorldOfSpectrum::getScreenshot(GameEntry &)
 {
   if(data.indexOf("<IMG SRC=\"/pub/sinclair/screens/in-game") == -1) {
     return;
@@ -155,14 +150,9 @@ void WorldOfSpectrum::getScreenshot(GameEntry &game)
   nomNom("<IMG SRC=\"");
   QString screenshotUrl = data.left(data.indexOf(screenshotPost));
   if(screenshotUrl.indexOf("http") != -1) {
-    manager.request(screenshotUrl);
+    addToFetchPlan(SCREENSHOT, screenshotUrl);
   } else {
-    manager.request(baseUrl + (screenshotUrl.left(1) == "/"?"":"/") + screenshotUrl);
-  }
-  q.exec();
-  QImage image(QImage::fromData(manager.getData()));
-  if(!image.isNull()) {
-    game.screenshotData = image;
+    addToFetchPlan(SCREENSHOT, baseUrl + (screenshotUrl.left(1) == "/"?"":"/") + screenshotUrl);
   }
 }
 
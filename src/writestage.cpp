@@ -0,0 +1,227 @@
+/***************************************************************************
+ *            writestage.cpp
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QRunnable>
+#include <QFile>
+#include <QElapsedTimer>
+
+#include "writestage.h"
+#include "compositor.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+class WriteRunner : public QRunnable
+{
+public:
+  WriteRunner(WriteStage *writeStage, QSemaphore *freeSlots, const GameEntry &game,
+	      QSharedPointer<PlatformRun> platformRun)
+  {
+    this->writeStage = writeStage;
+    this->freeSlots = freeSlots;
+    this->game = game;
+    this->platformRun = platformRun;
+  }
+  void run()
+  {
+    writeStage->writeEntry(game, *platformRun);
+    // Release media data before giving back the slot
+    game = GameEntry();
+    freeSlots->release();
+  }
+
+private:
+  WriteStage *writeStage;
+  QSemaphore *freeSlots;
+  GameEntry game;
+  QSharedPointer<PlatformRun> platformRun;
+};
+
+WriteStage::WriteStage(int threads)
+{
+  pool.setMaxThreadCount(threads < 1?1:threads);
+  // Each pending entry holds on to its media data, so limit how many can wait
+  freeSlots.release(pool.maxThreadCount() * 2);
+  blockedMsecs = 0;
+}
+
+WriteStage::~WriteStage()
+{
+  pool.waitForDone();
+}
+
+// Blocks while the stage is full, making fast scraper threads wait for the disk
+void WriteStage::addEntry(const GameEntry &game, QSharedPointer<PlatformRun> platformRun)
+{
+  if(!freeSlots.tryAcquire()) {
+    QElapsedTimer blockedTimer;
+    blockedTimer.start();
+    freeSlots.acquire();
+    statsMutex.lock();
+    blockedMsecs += blockedTimer.elapsed();
+    statsMutex.unlock();
+  }
+  pool.start(new WriteRunner(this, &freeSlots, game, platformRun));
+}
+
+void WriteStage::waitForDone()
+{
+  pool.waitForDone();
+}
+
+// Returns the time scraper threads have spent waiting for this stage since last call
+qint64 WriteStage::takeBlockedMsecs()
+{
+  QMutexLocker locker(&statsMutex);
+  qint64 msecs = blockedMsecs;
+  blockedMsecs = 0;
+  return msecs;
+}
+
+void WriteStage::writeEntry(GameEntry &game, PlatformRun &platformRun)
+{
+  const Settings &config = platformRun.config;
+  QSharedPointer<LocalDb> localDb = platformRun.localDb;
+  QSharedPointer<Journal> journal = platformRun.journal;
+  QSharedPointer<DupeTracker> dupes = platformRun.dupes;
+
+  // Games that weren't found have nothing to write, but still go in the journal
+  if(!game.found) {
+    if(!journal.isNull()) {
+      journal->addRecord(game, 0, QList<Resource>());
+    }
+    return;
+  }
+  int completeness = game.completeness(config.videos);
+
+  // Renamed roms keep their media, it just gets their new name
+  if(!game.movedFrom.isEmpty()) {
+    if(!config.pretend) {
+      moveMedia(config.imagesFolder + "/" + game.movedFrom + ".png",
+		config.imagesFolder + "/" + game.baseName + ".png");
+      if(config.videos && game.videoFormat != "") {
+	moveMedia(config.videosFolder + "/" + game.movedFrom + "." + game.videoFormat,
+		  config.videosFolder + "/" + game.baseName + "." + game.videoFormat);
+      }
+    }
+    // A renamed zip has a new db key, so its resources are copied over
+    QList<Resource> resources;
+    if(config.localDb && config.scraper != "localdb" && !config.pretend &&
+       game.sha1 != game.originalSha1) {
+      resources = localDb->copyResources(game.originalSha1, game.sha1, config.scraper,
+					  config.updateDb);
+    }
+    if(!dupes.isNull()) {
+      dupes->written(game.sha1);
+    }
+    if(!journal.isNull()) {
+      journal->addRecord(game, completeness, resources);
+    }
+    return;
+  }
+
+  // Copies of a rom link to the media of the original. The write stage runs entries
+  // in the order they were added, so the original is already being written
+  if(!game.mediaSource.isEmpty()) {
+    if(!dupes.isNull()) {
+      dupes->waitUntilWritten(game.originalSha1);
+    }
+    if(!config.pretend) {
+      linkMedia(config.imagesFolder + "/" + game.mediaSource + ".png",
+		config.imagesFolder + "/" + game.baseName + ".png");
+      if(config.videos && game.videoFormat != "") {
+	linkMedia(config.videosFolder + "/" + game.mediaSource + "." + game.videoFormat,
+		  config.videosFolder + "/" + game.baseName + "." + game.videoFormat);
+      }
+    }
+    // Other disks of a game have their own db key, so they get the resources too
+    QList<Resource> resources;
+    if(config.localDb && config.scraper != "localdb" && !config.pretend &&
+       game.sha1 != game.originalSha1) {
+      resources = localDb->copyResources(game.originalSha1, game.sha1, config.scraper,
+					  config.updateDb);
+    }
+    if(!journal.isNull()) {
+      journal->addRecord(game, completeness, resources);
+    }
+    return;
+  }
+
+  if(!config.pretend) {
+    if(config.frontend != "attractmode") {
+      Compositor artCreator;
+      artCreator.composite(game.coverData, game.screenshotData, config).save(config.imagesFolder + "/" + game.baseName + ".png");
+    } else {
+      game.screenshotData.save(config.imagesFolder + "/" + game.baseName + ".png");
+    }
+  }
+
+  if(config.videos && game.videoFormat != "") {
+    QFile videoFile(config.videosFolder + "/" + game.baseName + "." + game.videoFormat);
+    if(videoFile.open(QIODevice::WriteOnly)) {
+      videoFile.write(game.videoData);
+      videoFile.close();
+    }
+  }
+
+  QList<Resource> resources;
+  if(config.localDb && config.scraper != "localdb" && !config.pretend && game.found) {
+    game.source = config.scraper;
+    resources = localDb->addResources(game, config.updateDb);
+  }
+
+  if(!dupes.isNull()) {
+    dupes->written(game.sha1);
+  }
+
+  if(!journal.isNull()) {
+    journal->addRecord(game, completeness, resources);
+  }
+}
+
+// Hard links a media file where the filesystem allows it, otherwise copies it
+void WriteStage::linkMedia(const QString &source, const QString &target)
+{
+  if(source == target || !QFile::exists(source)) {
+    return;
+  }
+  QFile::remove(target);
+#ifdef Q_OS_UNIX
+  if(link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0) {
+    return;
+  }
+#endif
+  QFile::copy(source, target);
+}
+
+void WriteStage::moveMedia(const QString &source, const QString &target)
+{
+  if(source == target || !QFile::exists(source)) {
+    return;
+  }
+  QFile::remove(target);
+  QFile::rename(source, target);
+}
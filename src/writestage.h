@@ -0,0 +1,61 @@
+/***************************************************************************
+ *            writestage.h
+ *
+ *  Wed Jan 3 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef WRITESTAGE_H
+#define WRITESTAGE_H
+
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "gameentry.h"
+#include "platformrun.h"
+
+// Last stage of the scraping pipeline. Composites the final artwork and writes
+// images, videos and local db resources to disk on its own threads, so the
+// scraper threads can move on to the next game right away. Each entry is
+// written with the settings, db and journal of the platform it belongs to.
+class WriteStage
+{
+public:
+  WriteStage(int threads);
+  ~WriteStage();
+  void addEntry(const GameEntry &game, QSharedPointer<PlatformRun> platformRun);
+  void waitForDone();
+  qint64 takeBlockedMsecs();
+  void writeEntry(GameEntry &game, PlatformRun &platformRun);
+
+private:
+  static void linkMedia(const QString &source, const QString &target);
+  static void moveMedia(const QString &source, const QString &target);
+  QThreadPool pool;
+  QSemaphore freeSlots;
+  QMutex statsMutex;
+  qint64 blockedMsecs;
+
+};
+
+#endif // WRITESTAGE_H
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *            xmlindex.cpp
+ *
+ *  Sat Jan 20 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QXmlStreamReader>
+
+#include "xmlindex.h"
+
+#define INDEXMAGIC 0x534b5849
+// Bump this whenever the records change
+#define INDEXVERSION 1
+
+XmlIndex::XmlIndex(const QString &dbFolder)
+{
+  xmlFileString = dbFolder + "/db.xml";
+  xmlFile.setFileName(xmlFileString);
+  indexFile.setFileName(xmlFileString + ".idx");
+  newFile.setFileName(xmlFileString + ".idx");
+  remaining = 0;
+}
+
+XmlIndex::~XmlIndex()
+{
+  indexFile.close();
+  xmlFile.close();
+}
+
+// Starts reading the resources from the beginning. Fails if the index is missing
+// or wasn't made from the current 'db.xml'
+bool XmlIndex::rewind()
+{
+  indexFile.close();
+  if(!indexFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&indexFile);
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint64 xmlSize = 0;
+  qint64 xmlModified = 0;
+  in >> magic >> version >> xmlSize >> xmlModified >> remaining;
+  QFileInfo xmlInfo(xmlFileString);
+  if(in.status() != QDataStream::Ok || magic != INDEXMAGIC || version != INDEXVERSION ||
+     xmlSize != xmlInfo.size() || xmlModified != xmlInfo.lastModified().toMSecsSinceEpoch()) {
+    indexFile.close();
+    return false;
+  }
+  return true;
+}
+
+bool XmlIndex::nextResource(Resource &resource)
+{
+  if(!indexFile.isOpen() || remaining == 0) {
+    indexFile.close();
+    return false;
+  }
+  QDataStream in(&indexFile);
+  resource = Resource();
+  in >> resource.sha1 >> resource.type >> resource.source >> resource.timestamp
+     >> resource.valueOffset >> resource.value;
+  remaining--;
+  return in.status() == QDataStream::Ok;
+}
+
+// Starts writing a new index for 'db.xml' as it is on disk now. It replaces the
+// current one on 'commit'
+bool XmlIndex::create()
+{
+  // 'db.xml' may have been replaced, values are read from the new one from now on
+  readMutex.lock();
+  xmlFile.close();
+  readMutex.unlock();
+  if(!newFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QFileInfo xmlInfo(xmlFileString);
+  QDataStream out(&newFile);
+  // The number of resources is filled in on 'commit'
+  out << (quint32)INDEXMAGIC << (quint32)INDEXVERSION << (qint64)xmlInfo.size()
+      << (qint64)xmlInfo.lastModified().toMSecsSinceEpoch() << (quint32)0;
+  remaining = 0;
+  return true;
+}
+
+void XmlIndex::addResource(const Resource &resource)
+{
+  QDataStream out(&newFile);
+  out << resource.sha1 << resource.type << resource.source << resource.timestamp
+      << resource.valueOffset << resource.value;
+  remaining++;
+}
+
+bool XmlIndex::commit()
+{
+  // Magic, version, size and modification time come before the count
+  newFile.seek(24);
+  QDataStream out(&newFile);
+  out << remaining;
+  return newFile.commit();
+}
+
+// Reads the value of the resource element whose start tag ends at 'offset'
+QString XmlIndex::readValue(const qint64 &offset)
+{
+  QMutexLocker locker(&readMutex);
+  if(!xmlFile.isOpen() && !xmlFile.open(QIODevice::ReadOnly)) {
+    return QString();
+  }
+  if(!xmlFile.seek(offset)) {
+    return QString();
+  }
+  QByteArray element;
+  int end = -1;
+  while(end == -1 && !xmlFile.atEnd()) {
+    element.append(xmlFile.read(4096));
+    end = element.indexOf("</resource>");
+  }
+  if(end == -1 || !element.startsWith('>')) {
+    return QString();
+  }
+  // Let the xml reader take care of entities
+  QXmlStreamReader xml("<value" + element.left(end) + "</value>");
+  if(!xml.readNextStartElement()) {
+    return QString();
+  }
+  return xml.readElementText();
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+ *            xmlindex.h
+ *
+ *  Sat Jan 20 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef XMLINDEX_H
+#define XMLINDEX_H
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QMutex>
+
+#include "localdb.h"
+
+// Side index for 'db.xml' in 'db.xml.idx'. It holds every resource of the db,
+// except for the values of the large text resources. Those only have the offset
+// of their element in 'db.xml' and are read from there when a game needs them.
+// The index is only used while the size and modification time of 'db.xml' match
+// those it was made from.
+class XmlIndex
+{
+public:
+  XmlIndex(const QString &dbFolder);
+  ~XmlIndex();
+  bool rewind();
+  bool nextResource(Resource &resource);
+  bool create();
+  void addResource(const Resource &resource);
+  bool commit();
+  QString readValue(const qint64 &offset);
+
+private:
+  QString xmlFileString;
+  QFile xmlFile;
+  QFile indexFile;
+  QSaveFile newFile;
+  QMutex readMutex;
+  quint32 remaining;
+
+};
+
+#endif // XMLINDEX_H
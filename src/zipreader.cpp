@@ -0,0 +1,235 @@
+/***************************************************************************
+ *            zipreader.cpp
+ *
+ *  Mon Jan 15 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#include <QtEndian>
+
+#include "zipreader.h"
+
+#define BLOCKSIZE 1048576
+// End of central directory record is 22 bytes plus a comment of up to 64 KB
+#define EOCDSEARCH 65557
+
+ZipReader::ZipReader()
+{
+  inBuffer.resize(BLOCKSIZE);
+  outBuffer.resize(BLOCKSIZE);
+  inflating = false;
+}
+
+ZipReader::~ZipReader()
+{
+  close();
+}
+
+bool ZipReader::openLargestMember(const QString &path)
+{
+  close();
+  zipFile.setFileName(path);
+  if(!zipFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    return false;
+  }
+  if(!findLargestMember()) {
+    close();
+    return false;
+  }
+
+  // The local header has its own name and extra field lengths, so read it to
+  // find out where the data begins
+  uchar header[30];
+  if(!zipFile.seek(memberOffset) || zipFile.read((char *)header, 30) != 30 ||
+     qFromLittleEndian<quint32>(header) != 0x04034b50) {
+    close();
+    return false;
+  }
+  qint64 dataOffset = (qint64)memberOffset + 30 +
+    qFromLittleEndian<quint16>(header + 26) + qFromLittleEndian<quint16>(header + 28);
+  if(!zipFile.seek(dataOffset)) {
+    close();
+    return false;
+  }
+  remaining = compressedSize;
+
+  if(method == 8) {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    // Negative window bits means raw deflate data without a zlib header
+    if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+      close();
+      return false;
+    }
+    inflating = true;
+  }
+  return true;
+}
+
+// Returns the number of uncompressed bytes in 'data', 0 when the member has been
+// read completely and -1 if the data is corrupt
+qint64 ZipReader::readBlock(const char *&data)
+{
+  if(method == 0) {
+    if(remaining == 0) {
+      return 0;
+    }
+    // Network filesystems may return less than asked for, so keep going until full.
+    // The rom digester relies on whole blocks to swap the byte order
+    qint64 wanted = qMin(remaining, (qint64)BLOCKSIZE);
+    qint64 length = 0;
+    while(length < wanted) {
+      qint64 bytesRead = zipFile.read(inBuffer.data() + length, wanted - length);
+      if(bytesRead <= 0) {
+	// The member is cut short if the file ends before its data does
+	return -1;
+      }
+      length += bytesRead;
+    }
+    remaining -= length;
+    data = inBuffer.constData();
+    return length;
+  }
+
+  if(!inflating) {
+    return 0;
+  }
+  stream.next_out = (Bytef *)outBuffer.data();
+  stream.avail_out = BLOCKSIZE;
+  while(stream.avail_out > 0) {
+    if(stream.avail_in == 0 && remaining > 0) {
+      qint64 bytesRead = zipFile.read(inBuffer.data(), qMin(remaining, (qint64)BLOCKSIZE));
+      if(bytesRead <= 0) {
+	return -1;
+      }
+      remaining -= bytesRead;
+      stream.next_in = (Bytef *)inBuffer.data();
+      stream.avail_in = bytesRead;
+    }
+    int result = inflate(&stream, Z_NO_FLUSH);
+    if(result == Z_STREAM_END) {
+      inflateEnd(&stream);
+      inflating = false;
+      break;
+    }
+    if(result != Z_OK) {
+      return -1;
+    }
+  }
+  data = outBuffer.constData();
+  return BLOCKSIZE - stream.avail_out;
+}
+
+void ZipReader::close()
+{
+  if(inflating) {
+    inflateEnd(&stream);
+    inflating = false;
+  }
+  if(zipFile.isOpen()) {
+    zipFile.close();
+  }
+}
+
+QString ZipReader::getMemberName()
+{
+  return memberName;
+}
+
+qint64 ZipReader::getMemberSize()
+{
+  return memberSize;
+}
+
+// Reads the central directory at the end of the file and picks the largest file,
+// which is the rom itself in any zip that also holds readme or nfo files
+bool ZipReader::findLargestMember()
+{
+  qint64 tailSize = qMin(zipFile.size(), (qint64)EOCDSEARCH);
+  if(tailSize < 22 || !zipFile.seek(zipFile.size() - tailSize)) {
+    return false;
+  }
+  QByteArray tail = zipFile.read(tailSize);
+  const uchar *tailData = (const uchar *)tail.constData();
+  int eocd = -1;
+  for(int a = tail.length() - 22; a >= 0; --a) {
+    if(qFromLittleEndian<quint32>(tailData + a) == 0x06054b50) {
+      eocd = a;
+      break;
+    }
+  }
+  if(eocd == -1) {
+    return false;
+  }
+  quint16 entries = qFromLittleEndian<quint16>(tailData + eocd + 10);
+  quint32 dirSize = qFromLittleEndian<quint32>(tailData + eocd + 12);
+  quint32 dirOffset = qFromLittleEndian<quint32>(tailData + eocd + 16);
+  // Zip64 archives mark these with all bits set. They are not supported
+  if(entries == 0xffff || dirSize == 0xffffffff || dirOffset == 0xffffffff) {
+    return false;
+  }
+  if(!zipFile.seek(dirOffset)) {
+    return false;
+  }
+  QByteArray dir = zipFile.read(dirSize);
+  if((quint32)dir.length() != dirSize) {
+    return false;
+  }
+
+  const uchar *dirData = (const uchar *)dir.constData();
+  quint32 largestSize = 0;
+  bool found = false;
+  int pos = 0;
+  for(int a = 0; a < entries; ++a) {
+    if(pos + 46 > dir.length() ||
+       qFromLittleEndian<quint32>(dirData + pos) != 0x02014b50) {
+      return false;
+    }
+    quint16 flags = qFromLittleEndian<quint16>(dirData + pos + 8);
+    quint16 entryMethod = qFromLittleEndian<quint16>(dirData + pos + 10);
+    quint32 entryCompressed = qFromLittleEndian<quint32>(dirData + pos + 20);
+    quint32 entrySize = qFromLittleEndian<quint32>(dirData + pos + 24);
+    quint16 nameLength = qFromLittleEndian<quint16>(dirData + pos + 28);
+    quint16 extraLength = qFromLittleEndian<quint16>(dirData + pos + 30);
+    quint16 commentLength = qFromLittleEndian<quint16>(dirData + pos + 32);
+    quint32 entryOffset = qFromLittleEndian<quint32>(dirData + pos + 42);
+    if(pos + 46 + nameLength > dir.length()) {
+      return false;
+    }
+    QString entryName = QString::fromUtf8(dir.mid(pos + 46, nameLength));
+    // Skip folders and encrypted files
+    if(!entryName.endsWith("/") && !(flags & 1) && (!found || entrySize > largestSize)) {
+      largestSize = entrySize;
+      memberName = entryName;
+      method = entryMethod;
+      compressedSize = entryCompressed;
+      memberSize = entrySize;
+      memberOffset = entryOffset;
+      found = true;
+    }
+    pos += 46 + nameLength + extraLength + commentLength;
+  }
+  return found && (method == 0 || method == 8);
+}
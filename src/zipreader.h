@@ -0,0 +1,65 @@
+/***************************************************************************
+ *            zipreader.h
+ *
+ *  Mon Jan 15 12:00:00 CEST 2018
+ *  Copyright 2018 Lars Muldjord
+ *  muldjordlars@gmail.com
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <QFile>
+#include <QByteArray>
+
+#include <zlib.h>
+
+// Streams the rom inside a zip file without extracting it to disk, so its
+// checksums can be compared to the ones in the rom databases. Only 'stored'
+// and 'deflated' members are supported, which covers almost all rom sets.
+class ZipReader
+{
+public:
+  ZipReader();
+  ~ZipReader();
+  bool openLargestMember(const QString &path);
+  qint64 readBlock(const char *&data);
+  void close();
+  QString getMemberName();
+  qint64 getMemberSize();
+
+private:
+  bool findLargestMember();
+  QFile zipFile;
+  QByteArray inBuffer;
+  QByteArray outBuffer;
+  z_stream stream;
+  bool inflating;
+  QString memberName;
+  quint16 method;
+  quint32 compressedSize;
+  quint32 memberSize;
+  quint32 memberOffset;
+  qint64 remaining;
+
+};
+
+#endif // ZIPREADER_H